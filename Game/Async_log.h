@@ -0,0 +1,100 @@
+#pragma once
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Запись в файл в фоновом потоке: вызывающий только кладёт задание в очередь,
+// а открытие, форматирование и запись на диск идут в потоке записи.
+// Задания выполняются по порядку, после каждой пачки файл сбрасывается на диск.
+class Async_log
+{
+  public:
+    ~Async_log()
+    {
+        close();
+    }
+
+    // Открывает файл (append — дописывать, иначе очистить) и запускает поток записи.
+    // Если файл не открылся, задания просто отбрасываются.
+    void open(const string& path, const bool append)
+    {
+        close();
+        // Файл всегда открыт на дописывание, чтобы не затирать строки,
+        // которые другие части программы дописывают в тот же файл напрямую
+        if (!append)
+            ofstream(path, ios_base::trunc);
+        file.open(path, ios_base::app);
+        if (!file)
+            return;
+        stopping = false;
+        worker = thread([this]() { run(); });
+    }
+
+    bool is_open() const
+    {
+        return worker.joinable();
+    }
+
+    // Задание записи: получает поток файла, вызывается в потоке записи
+    void post(function<void(ostream&)> job)
+    {
+        if (!is_open())
+            return;
+        {
+            lock_guard<mutex> lock(jobs_mutex);
+            jobs.push_back(move(job));
+        }
+        jobs_cv.notify_one();
+    }
+
+    void write(string text)
+    {
+        post([text = move(text)](ostream& out) { out << text; });
+    }
+
+    // Дописывает всю очередь и закрывает файл
+    void close()
+    {
+        if (!is_open())
+            return;
+        {
+            lock_guard<mutex> lock(jobs_mutex);
+            stopping = true;
+        }
+        jobs_cv.notify_one();
+        worker.join();
+        file.close();
+    }
+
+  private:
+    void run()
+    {
+        unique_lock<mutex> lock(jobs_mutex);
+        while (true)
+        {
+            jobs_cv.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+                break;
+            vector<function<void(ostream&)>> batch;
+            batch.swap(jobs);
+            lock.unlock();
+            for (auto& job : batch)
+                job(file);
+            file.flush();
+            lock.lock();
+        }
+    }
+
+    ofstream file;
+    thread worker;
+    mutex jobs_mutex;
+    condition_variable jobs_cv;
+    vector<function<void(ostream&)>> jobs;
+    bool stopping = false;
+};
@@ -5,6 +5,8 @@
 
 #include "../Models/Move.h"
 #include "../Models/Project_path.h"
+#include "State.h"
+#include "Texture_atlas.h"
 
 #ifdef __APPLE__
 #include <SDL2/SDL.h>
@@ -16,13 +18,21 @@
 
 using namespace std;
 
+// Отрисовка партии в окне SDL. Сама партия (позиция и история) хранится в State,
+// Board только показывает её.
+// Изменения (ходы, подсветка, активная клетка) не рисуются сразу: они копятся до flush(),
+// который вызывается перед ожиданием ввода и после каждого шага хода бота.
+// Кадр хранится в текстуре frame, и flush() перерисовывает в ней только клетки,
+// которые отличаются от нарисованных, а окно обновляет не чаще раза за кадр монитора.
 class Board
 {
 public:
-    Board() = default;
+    Board(State* state) : state(state)
+    {
+    }
 
     // Конструктор, позволяющий задать размеры окна заранее
-    Board(const unsigned int W, const unsigned int H) : W(W), H(H)
+    Board(State* state, const unsigned int W, const unsigned int H) : W(W), H(H), state(state)
     {
     }
 
@@ -67,30 +77,23 @@ public:
             return 1;
         }
 
-        // Загрузка всех текстур
-        board = IMG_LoadTexture(ren, board_path.c_str());
-        w_piece = IMG_LoadTexture(ren, piece_white_path.c_str());
-        b_piece = IMG_LoadTexture(ren, piece_black_path.c_str());
-        w_queen = IMG_LoadTexture(ren, queen_white_path.c_str());
-        b_queen = IMG_LoadTexture(ren, queen_black_path.c_str());
-        back = IMG_LoadTexture(ren, back_path.c_str());
-        replay = IMG_LoadTexture(ren, replay_path.c_str());
-
-        // Проверка, что все текстуры загружены
-        if (!board || !w_piece || !b_piece || !w_queen || !b_queen || !back || !replay)
+        // Загрузка всех текстур: картинки читаются с диска один раз
+        if (!textures.load(ren, textures_path))
         {
-            print_exception("IMG_LoadTexture can't load main textures from " + textures_path);
+            print_exception(textures.error());
             return 1;
         }
 
-        // Получаем реальный размер окна
-        SDL_GetRendererOutputSize(ren, &W, &H);
+        // Длительность кадра монитора, на котором окно
+        SDL_DisplayMode mode;
+        if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(win), &mode) == 0 && mode.refresh_rate > 0)
+            frame_ms = 1000 / mode.refresh_rate;
 
-        // Создаём стартовую матрицу шашек
-        make_start_mtx();
+        // Получаем реальный размер окна и создаём текстуру кадра
+        reset_window_size();
 
         // Первая отрисовка
-        rerender();
+        present();
         return 0;
     }
 
@@ -98,9 +101,7 @@ public:
     void redraw()
     {
         game_results = -1;
-        history_mtx.clear();
-        history_beat_series.clear();
-        make_start_mtx();
+        state->reset();
         clear_active();
         clear_highlight();
     }
@@ -108,59 +109,33 @@ public:
     // Перемещение шашки с возможным удалением побитой
     void move_piece(move_pos turn, const int beat_series = 0)
     {
-        // Если был удар — удаляем побитую шашку
-        if (turn.xb != -1)
-        {
-            mtx[turn.xb][turn.yb] = 0;
-        }
-        move_piece(turn.x, turn.y, turn.x2, turn.y2, beat_series);
+        state->move_piece(turn, beat_series);
+        changed = true;
     }
 
-    // Основная логика перемещения шашки
+    // Перемещение шашки без удара
     void move_piece(const POS_T i, const POS_T j, const POS_T i2, const POS_T j2, const int beat_series = 0)
     {
-        // Проверка корректности хода
-        if (mtx[i2][j2])
-        {
-            throw runtime_error("final position is not empty, can't move");
-        }
-        if (!mtx[i][j])
-        {
-            throw runtime_error("begin position is empty, can't move");
-        }
-
-        // Превращение в дамку
-        if ((mtx[i][j] == 1 && i2 == 0) || (mtx[i][j] == 2 && i2 == 7))
-            mtx[i][j] += 2;
-
-        // Перемещение шашки
-        mtx[i2][j2] = mtx[i][j];
-        drop_piece(i, j);
-
-        // Сохраняем состояние в историю
-        add_history(beat_series);
+        state->move_piece(i, j, i2, j2, beat_series);
+        changed = true;
     }
 
     // Удаление шашки с клетки
     void drop_piece(const POS_T i, const POS_T j)
     {
-        mtx[i][j] = 0;
-        rerender();
+        state->drop_piece(i, j);
+        changed = true;
     }
 
     // Превращение шашки в дамку вручную
     void turn_into_queen(const POS_T i, const POS_T j)
     {
-        if (mtx[i][j] == 0 || mtx[i][j] > 2)
-        {
-            throw runtime_error("can't turn into queen in this position");
-        }
-        mtx[i][j] += 2;
-        rerender();
+        state->turn_into_queen(i, j);
+        changed = true;
     }
     vector<vector<POS_T>> get_board() const
     {
-        return mtx;
+        return state->get_board();
     }
 
     // Подсветка возможных ходов
@@ -169,7 +144,7 @@ public:
         for (auto pos : cells)
             is_highlighted_[pos.first][pos.second] = 1;
 
-        rerender();
+        changed = true;
     }
 
     // Сброс подсветки
@@ -179,7 +154,7 @@ public:
         {
             is_highlighted_[i].assign(8, 0);
         }
-        rerender();
+        changed = true;
     }
 
     // Установка активной клетки (красная рамка)
@@ -187,7 +162,7 @@ public:
     {
         active_x = x;
         active_y = y;
-        rerender();
+        changed = true;
     }
 
     // Сброс активной клетки
@@ -195,23 +170,13 @@ public:
     {
         active_x = -1;
         active_y = -1;
-        rerender();
+        changed = true;
     }
 
     // Откат хода с учётом серии ударов
     void rollback()
     {
-        auto beat_series = max(1, *(history_beat_series.rbegin()));
-
-        // Удаляем из истории все состояния, относящиеся к серии ударов
-        while (beat_series-- && history_mtx.size() > 1)
-        {
-            history_mtx.pop_back();
-            history_beat_series.pop_back();
-        }
-
-        // Восстанавливаем матрицу
-        mtx = *(history_mtx.rbegin());
+        state->rollback();
         clear_highlight();
         clear_active();
     }
@@ -220,26 +185,56 @@ public:
     void show_final(const int res)
     {
         game_results = res;
-        rerender();
+        changed = true;
     }
 
-    // Обновление размеров окна при ресайзе
+    // Обновление размеров окна при ресайзе: кадр пересоздаётся и рисуется заново целиком
     void reset_window_size()
     {
         SDL_GetRendererOutputSize(ren, &W, &H);
+        if (frame)
+            SDL_DestroyTexture(frame);
+        // Если рендер не умеет рисовать в текстуру, каждый кадр рисуется целиком прямо в окно
+        frame = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, W, H);
+        full_redraw = true;
+        changed = true;
+    }
+
+    // Пересоздание текстур после сброса устройства рендера: картинки берутся из памяти,
+    // затем кадр рисуется заново
+    void reload_textures()
+    {
+        if (!textures.rebuild())
+            print_exception(textures.error());
+        reset_window_size();
+    }
+
+    // Рисует накопленные изменения, если с прошлого обновления окна прошёл кадр.
+    // Возвращает, через сколько миллисекунд вызвать снова, чтобы нарисовать отложенные
+    // изменения, или -1, если рисовать нечего.
+    int flush()
+    {
+        if (!changed)
+            return -1;
+        const int wait_ms = int(last_present + frame_ms - SDL_GetTicks());
+        if (wait_ms > 0)
+            return wait_ms;
         rerender();
+        return -1;
+    }
+
+    // Рисует накопленные изменения сейчас, при необходимости дождавшись следующего кадра
+    void present()
+    {
+        for (int wait_ms = flush(); wait_ms > 0; wait_ms = flush())
+            SDL_Delay(wait_ms);
     }
 
     // Освобождение всех ресурсов SDL
     void quit()
     {
-        SDL_DestroyTexture(board);
-        SDL_DestroyTexture(w_piece);
-        SDL_DestroyTexture(b_piece);
-        SDL_DestroyTexture(w_queen);
-        SDL_DestroyTexture(b_queen);
-        SDL_DestroyTexture(back);
-        SDL_DestroyTexture(replay);
+        SDL_DestroyTexture(frame);
+        textures.free();
         SDL_DestroyRenderer(ren);
         SDL_DestroyWindow(win);
         SDL_Quit();
@@ -253,131 +248,134 @@ public:
 
 private:
 
-    // Добавление текущего состояния доски в историю
-    void add_history(const int beat_series = 0)
-    {
-        history_mtx.push_back(mtx);
-        history_beat_series.push_back(beat_series);
-    }
-
-    // Создание стартовой расстановки шашек
-    void make_start_mtx()
+    // Перерисовка окна. В текстуре кадра перерисовываются только изменившиеся клетки
+    // (или весь кадр после ресайза), затем кадр и картинка результата копируются в окно.
+    void rerender()
     {
-        for (POS_T i = 0; i < 8; ++i)
+        if (frame)
+            SDL_SetRenderTarget(ren, frame);
+        if (full_redraw || !frame)
         {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                mtx[i][j] = 0;
+            // draw board
+            SDL_RenderClear(ren);
+            textures.draw_background(NULL);
 
-                // Чёрные шашки
-                if (i < 3 && (i + j) % 2 == 1)
-                    mtx[i][j] = 2;
+            // Кнопка "назад"
+            SDL_Rect rect_left{ W / 40, H / 40, W / 15, H / 15 };
+            textures.draw(Sprite::BACK, rect_left);
 
-                // Белые шашки
-                if (i > 4 && (i + j) % 2 == 1)
-                    mtx[i][j] = 1;
-            }
+            // Кнопка "повтор"
+            SDL_Rect replay_rect{ W * 109 / 120, H / 40, W / 15, H / 15 };
+            textures.draw(Sprite::REPLAY, replay_rect);
         }
-        add_history();
-    }
-
-    // Полная перерисовка окна: доска, шашки, подсветка, кнопки, результат
-    void rerender()
-    {
-        // draw board
-        SDL_RenderClear(ren);
-        SDL_RenderCopy(ren, board, NULL, NULL);
 
-        // Отрисовка шашек
         for (POS_T i = 0; i < 8; ++i)
         {
             for (POS_T j = 0; j < 8; ++j)
             {
-                if (!mtx[i][j])
+                const cell_view view = current_view(i, j);
+                if (!full_redraw && frame && view == shown[i][j])
                     continue;
-
-                int wpos = W * (j + 1) / 10 + W / 120;
-                int hpos = H * (i + 1) / 10 + H / 120;
-                SDL_Rect rect{ wpos, hpos, W / 12, H / 12 };
-
-                SDL_Texture* piece_texture =
-                    (mtx[i][j] == 1) ? w_piece :
-                    (mtx[i][j] == 2) ? b_piece :
-                    (mtx[i][j] == 3) ? w_queen : b_queen;
-
-                SDL_RenderCopy(ren, piece_texture, NULL, &rect);
+                draw_cell(i, j, view);
+                shown[i][j] = view;
             }
         }
+        SDL_RenderSetClipRect(ren, NULL);
+        full_redraw = false;
 
-        // Подсветка возможных ходов
-        SDL_SetRenderDrawColor(ren, 0, 255, 0, 0);
-        const double scale = 2.5;
-        SDL_RenderSetScale(ren, scale, scale);
-
-        for (POS_T i = 0; i < 8; ++i)
+        if (frame)
         {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                if (!is_highlighted_[i][j])
-                    continue;
+            SDL_SetRenderTarget(ren, NULL);
+            SDL_RenderCopy(ren, frame, NULL, NULL);
+        }
 
-                SDL_Rect cell{
-                    int(W * (j + 1) / 10 / scale),
-                    int(H * (i + 1) / 10 / scale),
-                    int(W / 10 / scale),
-                    int(H / 10 / scale)
-                };
-                SDL_RenderDrawRect(ren, &cell);
-            }
+        // Отрисовка результата игры поверх кадра
+        if (game_results != -1)
+        {
+            const Sprite result = (game_results == 1) ? Sprite::WHITE_WINS :
+                                  (game_results == 2) ? Sprite::BLACK_WINS : Sprite::DRAW;
+            SDL_Rect res_rect{ W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5 };
+            textures.draw(result, res_rect);
         }
 
-        // Подсветка активной клетки
-        if (active_x != -1)
+        SDL_RenderPresent(ren);
+        last_present = SDL_GetTicks();
+        changed = false;
+
+        // Для macOS — предотвращает зависание окна. События только перекачиваются в очередь,
+        // а не забираются из неё, чтобы клик игрока во время отрисовки не терялся.
+        SDL_PumpEvents();
+    }
+
+    // Что показано на клетке: фигура, подсветка возможного хода, активная клетка
+    struct cell_view
+    {
+        POS_T type = -1; // -1 — клетка ещё не нарисована
+        bool highlighted = false;
+        bool active = false;
+
+        bool operator==(const cell_view& other) const
         {
-            SDL_SetRenderDrawColor(ren, 255, 0, 0, 0);
-            SDL_Rect active_cell{
-                int(W * (active_y + 1) / 10 / scale),
-                int(H * (active_x + 1) / 10 / scale),
-                int(W / 10 / scale),
-                int(H / 10 / scale)
-            };
-            SDL_RenderDrawRect(ren, &active_cell);
+            return type == other.type && highlighted == other.highlighted && active == other.active;
         }
-        SDL_RenderSetScale(ren, 1, 1);
+    };
 
-        // Кнопка "назад"
-        SDL_Rect rect_left{ W / 40, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, back, NULL, &rect_left);
+    cell_view current_view(const POS_T i, const POS_T j) const
+    {
+        cell_view view;
+        view.type = state->at(i, j);
+        view.highlighted = is_highlighted_[i][j];
+        view.active = active_x == i && active_y == j;
+        return view;
+    }
 
-        // Кнопка "повтор"
-        SDL_Rect replay_rect{ W * 109 / 120, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, replay, NULL, &replay_rect);
+    // Рисует одну клетку: фон доски под ней, шашку, рамки подсветки.
+    // Всё рисуется с обрезкой по клетке, поэтому соседние клетки не задеваются.
+    void draw_cell(const POS_T i, const POS_T j, const cell_view& view)
+    {
+        const SDL_Rect cell{ W * (j + 1) / 10, H * (i + 1) / 10, W * (j + 2) / 10 - W * (j + 1) / 10,
+                             H * (i + 2) / 10 - H * (i + 1) / 10 };
+        SDL_RenderSetClipRect(ren, &cell);
+        textures.draw_background(NULL);
 
-        // Отрисовка результата игры
-        if (game_results != -1)
+        // Отрисовка шашки
+        if (view.type)
         {
-            string result_path = draw_path;
-            if (game_results == 1) result_path = white_path;
-            else if (game_results == 2) result_path = black_path;
+            int wpos = W * (j + 1) / 10 + W / 120;
+            int hpos = H * (i + 1) / 10 + H / 120;
+            SDL_Rect rect{ wpos, hpos, W / 12, H / 12 };
 
-            SDL_Texture* result_texture = IMG_LoadTexture(ren, result_path.c_str());
-            if (!result_texture)
-            {
-                print_exception("IMG_LoadTexture can't load game result picture from " + result_path);
-                return;
-            }
+            const Sprite piece =
+                (view.type == 1) ? Sprite::WHITE_PIECE :
+                (view.type == 2) ? Sprite::BLACK_PIECE :
+                (view.type == 3) ? Sprite::WHITE_QUEEN : Sprite::BLACK_QUEEN;
 
-            SDL_Rect res_rect{ W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5 };
-            SDL_RenderCopy(ren, result_texture, NULL, &res_rect);
-            SDL_DestroyTexture(result_texture);
+            textures.draw(piece, rect);
         }
 
-        SDL_RenderPresent(ren);
+        // Подсветка возможного хода (зелёная рамка) и активной клетки (красная рамка)
+        if (view.highlighted)
+        {
+            SDL_SetRenderDrawColor(ren, 0, 255, 0, 0);
+            draw_frame(cell);
+        }
+        if (view.active)
+        {
+            SDL_SetRenderDrawColor(ren, 255, 0, 0, 0);
+            draw_frame(cell);
+        }
+    }
 
-        // Для macOS — предотвращает зависание окна
-        SDL_Delay(10);
-        SDL_Event windowEvent;
-        SDL_PollEvent(&windowEvent);
+    // Рамка по краю клетки толщиной FRAME_WIDTH
+    void draw_frame(const SDL_Rect& cell)
+    {
+        const SDL_Rect sides[4] = {
+            { cell.x, cell.y, cell.w, FRAME_WIDTH },
+            { cell.x, cell.y + cell.h - FRAME_WIDTH, cell.w, FRAME_WIDTH },
+            { cell.x, cell.y, FRAME_WIDTH, cell.h },
+            { cell.x + cell.w - FRAME_WIDTH, cell.y, FRAME_WIDTH, cell.h },
+        };
+        SDL_RenderFillRects(ren, sides, 4);
     }
 
     // Логирование ошибок SDL
@@ -391,41 +389,33 @@ private:
 public:
     int W = 0;
     int H = 0;
-    // history of boards
-    vector<vector<vector<POS_T>>> history_mtx;
+    // Показываемая партия
+    State* state;
 
 private:
+    // Толщина рамок подсветки в пикселях
+    static const int FRAME_WIDTH = 3;
+
     SDL_Window* win = nullptr;
     SDL_Renderer* ren = nullptr;
-    // textures
-    SDL_Texture* board = nullptr;
-    SDL_Texture* w_piece = nullptr;
-    SDL_Texture* b_piece = nullptr;
-    SDL_Texture* w_queen = nullptr;
-    SDL_Texture* b_queen = nullptr;
-    SDL_Texture* back = nullptr;
-    SDL_Texture* replay = nullptr;
-    // texture files names
+    // Текстура кадра, в которой перерисовываются только изменившиеся клетки
+    SDL_Texture* frame = nullptr;
+    // Фон доски и атлас шашек, кнопок и картинок результата
+    Texture_atlas textures;
     const string textures_path = project_path + "Textures/";
-    const string board_path = textures_path + "board.png";
-    const string piece_white_path = textures_path + "piece_white.png";
-    const string piece_black_path = textures_path + "piece_black.png";
-    const string queen_white_path = textures_path + "queen_white.png";
-    const string queen_black_path = textures_path + "queen_black.png";
-    const string white_path = textures_path + "white_wins.png";
-    const string black_path = textures_path + "black_wins.png";
-    const string draw_path = textures_path + "draw.png";
-    const string back_path = textures_path + "back.png";
-    const string replay_path = textures_path + "replay.png";
     // coordinates of chosen cell
     int active_x = -1, active_y = -1;
     // game result if exist
     int game_results = -1;
     // matrix of possible moves
     vector<vector<bool>> is_highlighted_ = vector<vector<bool>>(8, vector<bool>(8, 0));
-    // matrix of possible moves
-    // 1 - white, 2 - black, 3 - white queen, 4 - black queen
-    vector<vector<POS_T>> mtx = vector<vector<POS_T>>(8, vector<POS_T>(8, 0));
-    // series of beats for each move
-    vector<int> history_beat_series;
+    // Что сейчас нарисовано на каждой клетке кадра
+    cell_view shown[8][8];
+    // Есть изменения, которые ещё не показаны
+    bool changed = false;
+    // Кадр нужно нарисовать целиком (после создания или ресайза)
+    bool full_redraw = true;
+    // Длительность кадра монитора и время последнего обновления окна, мс
+    Uint32 frame_ms = 16;
+    Uint32 last_present = 0;
 };
\ No newline at end of file
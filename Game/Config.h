@@ -1,34 +1,311 @@
 #pragma once
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <initializer_list>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
+using namespace std;
 
 #include "../Models/Project_path.h"
 
+// Режим оптимизации поиска (Optimization): O0 — полный перебор, O1 — альфа-бета, O2 — ещё и PVS
+enum class Optimization
+{
+    O0,
+    O1,
+    O2
+};
+
+// Выбор хода дебютной книги (BookSelection)
+enum class Book_selection
+{
+    BEST,
+    WEIGHTED
+};
+
+// Наибольший уровень бота: глубина поиска вместе с форсированными взятиями должна помещаться в MAX_PLY
+const int MAX_BOT_LEVEL = 30;
+// Наибольший уровень без отсечений (Optimization = "O0"), дальше перебор слишком долгий
+const int MAX_O0_LEVEL = 7;
+
+// Раздел WindowSize
+struct window_settings
+{
+    int width = 500;
+    int height = 500; // ключ Hight
+};
+
+// Раздел Bot. Настройки сторон — по цвету: [0] — белые, [1] — чёрные.
+struct bot_settings
+{
+    bool is_bot[2] = {true, true};
+    int level[2] = {5, 5};
+    string scoring_type = "NumberOnly";
+    string eval_weights_path = "eval_weights.json";
+    int delay_ms = 0;
+    int time_limit_ms = 0;
+    Optimization optimization = Optimization::O2;
+    int table_size_mb = 16;
+    int threads = 0;
+    bool no_random = false;
+    bool ponder = true;
+    string tablebase_path = "Tablebases/";
+    int tablebase_pieces = 4;
+    string book_path = "Book/book.bin";
+    Book_selection book_selection = Book_selection::WEIGHTED;
+};
+
+// Раздел Game
+struct game_settings
+{
+    int max_turns = 120;
+    string telemetry_path = "telemetry.jsonl";
+};
+
+// Все настройки из settings.json. Значения по умолчанию совпадают с поставляемым файлом,
+// они используются для ключей, которых в файле нет.
+struct settings
+{
+    window_settings window;
+    bot_settings bot;
+    game_settings game;
+};
+
+// Настройки читаются из settings.json один раз: файл разбирается и проверяется целиком,
+// неизвестные ключи, значения не того типа и вне допустимых границ сообщаются все сразу.
+// Ключи *_comment — комментарии, они пропускаются.
 class Config
 {
 public:
+    // Бросает runtime_error со списком ошибок, если файл не читается или настройки неверны
     Config()
     {
-        reload();
+        if (!reload())
+            throw runtime_error(error_text);
     }
 
-    // Функция reload() перечитывает файл настроек settings.json и полностью перезагружает объект config.
+    // Перечитывает settings.json, если файл изменился с прошлого чтения.
+    // При ошибке прежние настройки остаются, а текст ошибки доступен через error().
+    bool reload()
+    {
+        const string path = project_path + "settings.json";
+        error_code ec;
+        const auto time = filesystem::last_write_time(path, ec);
+        if (loaded && !ec && time == write_time)
+            return true;
+        settings res;
+        if (!parse(path, res))
+            return false;
+        values = res;
+        write_time = time;
+        loaded = true;
+        return true;
+    }
 
-    void reload()
+    const settings& get() const
     {
-        std::ifstream fin(project_path + "settings.json");
-        fin >> config;   // Загружает JSON из файла в объект config
-        fin.close();
+        return values;
     }
 
-    // Оператор круглых скобок позволяет обращаться к настройкам в удобной форме: config("категория", "имя_параметра").
-    // По сути, это сокращение для config[setting_dir][setting_name].
-    auto operator()(const string& setting_dir, const string& setting_name) const
+    const string& error() const
     {
-        return config[setting_dir][setting_name];
+        return error_text;
     }
 
 private:
-    json config;
-};
\ No newline at end of file
+    bool parse(const string& path, settings& res)
+    {
+        ifstream fin(path);
+        if (!fin)
+            return fail("can't open " + path);
+        json js;
+        try
+        {
+            fin >> js;
+        }
+        catch (const json::exception& e)
+        {
+            return fail(path + ": " + e.what());
+        }
+        if (!js.is_object())
+            return fail(path + ": settings must be an object");
+
+        errors.clear();
+        known.clear();
+
+        const json& window = section(js, "WindowSize");
+        read(window, "WindowSize", "Width", res.window.width, 0, 16384);
+        read(window, "WindowSize", "Hight", res.window.height, 0, 16384);
+
+        const json& bot = section(js, "Bot");
+        read(bot, "Bot", "IsWhiteBot", res.bot.is_bot[0]);
+        read(bot, "Bot", "IsBlackBot", res.bot.is_bot[1]);
+        read(bot, "Bot", "WhiteBotLevel", res.bot.level[0], 0, MAX_BOT_LEVEL);
+        read(bot, "Bot", "BlackBotLevel", res.bot.level[1], 0, MAX_BOT_LEVEL);
+        int choice = -1;
+        read(bot, "Bot", "BotScoringType", choice, {"NumberOnly", "NumberAndPotential"});
+        if (choice != -1)
+            res.bot.scoring_type = choice ? "NumberAndPotential" : "NumberOnly";
+        read(bot, "Bot", "EvalWeightsPath", res.bot.eval_weights_path);
+        read(bot, "Bot", "BotDelayMS", res.bot.delay_ms, 0, 60000);
+        read(bot, "Bot", "BotTimeLimitMS", res.bot.time_limit_ms, 0, 3600000);
+        choice = -1;
+        read(bot, "Bot", "Optimization", choice, {"O0", "O1", "O2"});
+        if (choice != -1)
+            res.bot.optimization = Optimization(choice);
+        read(bot, "Bot", "TableSizeMB", res.bot.table_size_mb, 0, 65536);
+        read(bot, "Bot", "Threads", res.bot.threads, 0, 256);
+        read(bot, "Bot", "NoRandom", res.bot.no_random);
+        read(bot, "Bot", "Ponder", res.bot.ponder);
+        read(bot, "Bot", "TablebasePath", res.bot.tablebase_path);
+        read(bot, "Bot", "TablebasePieces", res.bot.tablebase_pieces, 0, 8);
+        read(bot, "Bot", "BookPath", res.bot.book_path);
+        choice = -1;
+        read(bot, "Bot", "BookSelection", choice, {"Best", "Weighted"});
+        if (choice != -1)
+            res.bot.book_selection = Book_selection(choice);
+
+        const json& game = section(js, "Game");
+        read(game, "Game", "MaxNumTurns", res.game.max_turns, 1, 10000);
+        read(game, "Game", "TelemetryPath", res.game.telemetry_path);
+
+        // Полный перебор на больших уровнях не закончится за разумное время
+        for (int color = 0; color < 2; ++color)
+        {
+            if (res.bot.optimization == Optimization::O0 && res.bot.is_bot[color] &&
+                res.bot.level[color] > MAX_O0_LEVEL)
+                errors.push_back(string("Bot.") + (color ? "Black" : "White") + "BotLevel must be at most " +
+                                 to_string(MAX_O0_LEVEL) + " with Optimization O0");
+        }
+
+        // Всё, что не прочитано выше, — опечатки или устаревшие ключи
+        for (const auto& item : js.items())
+        {
+            if (is_comment(item.key()))
+                continue;
+            if (!known.count(item.key()))
+            {
+                errors.push_back("unknown section " + item.key());
+                continue;
+            }
+            if (!item.value().is_object())
+                continue;
+            for (const auto& key : item.value().items())
+            {
+                if (!is_comment(key.key()) && !known.count(item.key() + "." + key.key()))
+                    errors.push_back("unknown key " + item.key() + "." + key.key());
+            }
+        }
+
+        if (errors.empty())
+            return true;
+        string text = path + ":";
+        for (const auto& e : errors)
+            text += "\n  " + e;
+        return fail(text);
+    }
+
+    // Раздел настроек; если его нет, все его ключи берутся по умолчанию
+    const json& section(const json& js, const string& name)
+    {
+        static const json empty = json::object();
+        known.insert(name);
+        if (!js.contains(name))
+            return empty;
+        if (!js[name].is_object())
+        {
+            errors.push_back(name + " must be an object");
+            return empty;
+        }
+        return js[name];
+    }
+
+    void read(const json& js, const string& sec, const string& key, int& value, const int min_value,
+              const int max_value)
+    {
+        known.insert(sec + "." + key);
+        if (!js.contains(key))
+            return;
+        const json& v = js[key];
+        if (!v.is_number_integer() || v.get<int64_t>() < min_value || v.get<int64_t>() > max_value)
+        {
+            errors.push_back(sec + "." + key + " must be an integer from " + to_string(min_value) + " to " +
+                             to_string(max_value));
+            return;
+        }
+        value = int(v.get<int64_t>());
+    }
+
+    void read(const json& js, const string& sec, const string& key, bool& value)
+    {
+        known.insert(sec + "." + key);
+        if (!js.contains(key))
+            return;
+        if (!js[key].is_boolean())
+        {
+            errors.push_back(sec + "." + key + " must be true or false");
+            return;
+        }
+        value = js[key].get<bool>();
+    }
+
+    void read(const json& js, const string& sec, const string& key, string& value)
+    {
+        known.insert(sec + "." + key);
+        if (!js.contains(key))
+            return;
+        if (!js[key].is_string())
+        {
+            errors.push_back(sec + "." + key + " must be a string");
+            return;
+        }
+        value = js[key].get<string>();
+    }
+
+    // Строка из списка вариантов: index — номер варианта, не меняется, если ключа нет
+    void read(const json& js, const string& sec, const string& key, int& index, initializer_list<const char*> choices)
+    {
+        known.insert(sec + "." + key);
+        if (!js.contains(key))
+            return;
+        const json& v = js[key];
+        int i = 0;
+        string list;
+        for (const char* choice : choices)
+        {
+            if (v.is_string() && v.get<string>() == choice)
+            {
+                index = i;
+                return;
+            }
+            list += string(i ? ", " : "") + choice;
+            ++i;
+        }
+        errors.push_back(sec + "." + key + " must be one of: " + list);
+    }
+
+    static bool is_comment(const string& key)
+    {
+        const string suffix = "_comment";
+        return key.size() >= suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool fail(const string& text)
+    {
+        error_text = text;
+        return false;
+    }
+
+    settings values;
+    bool loaded = false;
+    filesystem::file_time_type write_time;
+    string error_text;
+    // Ошибки и прочитанные ключи ("Раздел" и "Раздел.Ключ") текущего разбора
+    vector<string> errors;
+    set<string> known;
+};
@@ -0,0 +1,256 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../Models/Position.h"
+
+using namespace std;
+
+// Центр доски: c5, e5, d4, f4
+const uint32_t CENTER_MASK = 0x00066000u;
+
+// Клетки, на которые фигура может сделать тихий ход из клетки s без учёта занятости:
+// [0] — белая шашка, [1] — чёрная шашка, [2] — дамка (соседние клетки по всем диагоналям)
+constexpr array<array<uint32_t, 32>, 3> make_step_masks()
+{
+    array<array<uint32_t, 32>, 3> res{};
+    for (int s = 0; s < 32; ++s)
+    {
+        for (int d = 0; d < 4; ++d)
+        {
+            if (SQUARE_STEPS[s][d] == -1)
+                continue;
+            const uint32_t b = uint32_t(1) << SQUARE_STEPS[s][d];
+            res[d < 2 ? 0 : 1][s] |= b;
+            res[2][s] |= b;
+        }
+    }
+    return res;
+}
+
+constexpr array<array<uint32_t, 32>, 3> STEP_MASKS = make_step_masks();
+
+// Веса оценки в долях шашки. Таблицы клеток заданы для белых (клетки 0..31 построчно,
+// строка 0 — восьмая горизонталь), для чёрных доска поворачивается: клетка s переходит в 31 - s.
+// Веса клеток учитываются с точностью SQUARE_WEIGHT_UNIT (0.0001).
+struct eval_weights
+{
+    double man = 1;            // шашка
+    double king = 4;           // дамка
+    double advance = 0.04;     // каждая строка, пройденная шашкой к превращению
+    array<double, 32> man_table{};   // шашка на клетке
+    array<double, 32> king_table{};  // дамка на клетке
+    double back_rank = 0.1;    // шашка на своей первой строке, закрывающая путь в дамки
+    double center = 0.05;      // фигура в центре (c5, e5, d4, f4)
+    double mobility = 0.02;    // фигура, у которой есть тихий ход
+    double tempo = 0.03;       // очередь хода
+};
+
+// Оценка позиции по таблице весов.
+// NumberOnly — только материал (man, king), NumberAndPotential — все слагаемые.
+// Материал, продвижение и таблицы клеток берутся из счётчиков Position за O(1),
+// подвижность — обходом фигур, остальное — масками. Чтобы счётчики считали таблицы
+// этой оценки, позиция перед поиском подключается к ней через attach().
+class Evaluator
+{
+  public:
+    Evaluator()
+    {
+        set_weights(eval_weights());
+    }
+
+    // Читает веса из JSON-файла (см. eval_weights.json). Ключей, которых в файле нет,
+    // веса по умолчанию не меняются; если файла нет, остаются все веса по умолчанию.
+    // Файл проверяется целиком, как settings.json: неверный JSON, значения не того типа,
+    // таблицы не того размера и неизвестные ключи (кроме *_comment) сообщаются все сразу
+    // одним runtime_error с путём к файлу, прежние веса при этом не меняются.
+    void load(const string& path)
+    {
+        ifstream fin(path);
+        if (!fin)
+            return;
+        nlohmann::json js;
+        try
+        {
+            fin >> js;
+        }
+        catch (const nlohmann::json::exception& e)
+        {
+            throw runtime_error(path + ": " + e.what());
+        }
+        if (!js.is_object())
+            throw runtime_error(path + ": weights must be an object");
+
+        vector<string> errors;
+        eval_weights res;
+        read(js, "Man", res.man, errors);
+        read(js, "King", res.king, errors);
+        read(js, "Advance", res.advance, errors);
+        read(js, "ManTable", res.man_table, errors);
+        read(js, "KingTable", res.king_table, errors);
+        read(js, "BackRank", res.back_rank, errors);
+        read(js, "Center", res.center, errors);
+        read(js, "Mobility", res.mobility, errors);
+        read(js, "Tempo", res.tempo, errors);
+
+        // Всё, что не прочитано выше, — опечатки или устаревшие ключи
+        static const set<string> known = {"Man",     "King",     "Advance", "ManTable", "KingTable",
+                                          "BackRank", "Center", "Mobility", "Tempo"};
+        for (const auto& item : js.items())
+        {
+            if (!is_comment(item.key()) && !known.count(item.key()))
+                errors.push_back("unknown key " + item.key());
+        }
+
+        if (!errors.empty())
+        {
+            string text = path + ":";
+            for (const auto& e : errors)
+                text += "\n  " + e;
+            throw runtime_error(text);
+        }
+        set_weights(res);
+    }
+
+    // Режим оценки по BotScoringType
+    void set_scoring_type(const string& type)
+    {
+        if (type != "NumberOnly" && type != "NumberAndPotential")
+            throw runtime_error("unknown BotScoringType: " + type);
+        positional = type == "NumberAndPotential";
+    }
+
+    const eval_weights& weights() const
+    {
+        return w;
+    }
+
+    // Веса таблиц клеток округляются до SQUARE_WEIGHT_UNIT
+    void set_weights(const eval_weights& weights)
+    {
+        w = weights;
+        for (int s = 0; s < 32; ++s)
+        {
+            squares[0][s] = int32_t(lround(w.man_table[s] / SQUARE_WEIGHT_UNIT));
+            squares[1][s] = int32_t(lround(w.man_table[31 - s] / SQUARE_WEIGHT_UNIT));
+            squares[2][s] = int32_t(lround(w.king_table[s] / SQUARE_WEIGHT_UNIT));
+            squares[3][s] = int32_t(lround(w.king_table[31 - s] / SQUARE_WEIGHT_UNIT));
+        }
+    }
+
+    // Подключает счётчики позиции к таблицам клеток этой оценки.
+    // Позиция и её копии ссылаются на оценку, пока она существует и веса не меняются.
+    void attach(Position& pos) const
+    {
+        pos.set_square_weights(&squares);
+    }
+
+    // Оценка для стороны color, которая сейчас ходит.
+    // Если у одной из сторон нет фигур — это проигрыш (-inf) или победа (inf).
+    double score(const Position& pos, const bool color, const double inf) const
+    {
+        const eval_counters& c = pos.counters;
+        if (c.men(color) + c.kings(color) == 0)
+            return -inf;
+        if (c.men(!color) + c.kings(!color) == 0)
+            return inf;
+        double res = w.man * (c.men(color) - c.men(!color)) + w.king * (c.kings(color) - c.kings(!color));
+        if (!positional)
+            return res;
+        res += w.advance * (c.potential[color] - c.potential[!color]);
+        res += SQUARE_WEIGHT_UNIT * (c.square[color] - c.square[!color]);
+        res += positional_score(pos, color) - positional_score(pos, !color);
+        return res + w.tempo;
+    }
+
+  private:
+    // Слагаемые, которые считаются по фигурам одного цвета
+    double positional_score(const Position& pos, const bool color) const
+    {
+        const uint32_t own = pos.pieces(color), empty = ~pos.occupied();
+        const uint32_t men = own & ~pos.kings, kings = own & pos.kings;
+        double res = 0;
+        int mobile = 0;
+        for (uint32_t rest = men; rest;)
+        {
+            const int s = pop_lowest_bit(rest);
+            mobile += (STEP_MASKS[color][s] & empty) != 0;
+        }
+        for (uint32_t rest = kings; rest;)
+        {
+            const int s = pop_lowest_bit(rest);
+            mobile += (STEP_MASKS[2][s] & empty) != 0;
+        }
+        const uint32_t back_row = color ? WHITE_PROMOTION_ROW_MASK : BLACK_PROMOTION_ROW_MASK;
+        res += w.back_rank * bit_count(men & back_row);
+        res += w.center * bit_count(own & CENTER_MASK);
+        res += w.mobility * mobile;
+        return res;
+    }
+
+    static void read(const nlohmann::json& js, const char* key, double& value, vector<string>& errors)
+    {
+        if (!js.contains(key))
+            return;
+        if (!js[key].is_number())
+        {
+            errors.push_back(string(key) + " must be a number");
+            return;
+        }
+        value = js[key].get<double>();
+    }
+
+    // Таблица клеток задаётся восемью строками по четыре клетки
+    static void read(const nlohmann::json& js, const char* key, array<double, 32>& table, vector<string>& errors)
+    {
+        if (!js.contains(key))
+            return;
+        const auto& rows = js[key];
+        if (!rows.is_array() || rows.size() != 8)
+        {
+            errors.push_back(string(key) + " must be an array of 8 rows");
+            return;
+        }
+        for (int x = 0; x < 8; ++x)
+        {
+            const auto& row = rows[x];
+            if (!row.is_array() || row.size() != 4)
+            {
+                errors.push_back(string(key) + " row " + to_string(x) + " must be an array of 4 numbers");
+                continue;
+            }
+            for (int i = 0; i < 4; ++i)
+            {
+                if (!row[i].is_number() || abs(row[i].get<double>()) > MAX_SQUARE_WEIGHT)
+                {
+                    errors.push_back(string(key) + " row " + to_string(x) + " must be an array of 4 numbers from -" +
+                                     to_string(int(MAX_SQUARE_WEIGHT)) + " to " + to_string(int(MAX_SQUARE_WEIGHT)));
+                    break;
+                }
+                table[x * 4 + i] = row[i].get<double>();
+            }
+        }
+    }
+
+    static bool is_comment(const string& key)
+    {
+        const string suffix = "_comment";
+        return key.size() >= suffix.size() && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Наибольший по модулю вес клетки: суммы по 12 фигурам в единицах SQUARE_WEIGHT_UNIT помещаются в int32_t
+    static constexpr double MAX_SQUARE_WEIGHT = 100;
+
+    eval_weights w;
+    // Таблицы клеток [тип фигуры - 1][клетка] для счётчиков Position, для чёрных уже повёрнутые
+    square_weights squares{};
+    bool positional = false;
+};
@@ -3,18 +3,24 @@
 #include <thread>
 
 #include "../Models/Project_path.h"
+#include "Async_log.h"
 #include "Board.h"
 #include "Config.h"
 #include "Hand.h"
 #include "Logic.h"
+#include "State.h"
 
 class Game
 {
 public:
-    Game() : board(config("WindowSize", "Width"), config("WindowSize", "Hight")), hand(&board), logic(&board, &config)
+    Game() : board(&state, config.get().window.width, config.get().window.height), hand(&board), logic(&config)
     {
-        ofstream fout(project_path + "log.txt", ios_base::trunc);
-        fout.close();
+        // Логи пишутся в фоновом потоке, чтобы запись на диск не задерживала ходы
+        log_file.open(project_path + "log.txt", false);
+        const string& telemetry_path = config.get().game.telemetry_path;
+        if (!telemetry_path.empty())
+            telemetry_log.open(project_path + telemetry_path, false);
+        logic.on_ponder_done = Hand::wake;
     }
 
     // to start checkers
@@ -26,34 +32,50 @@ public:
         // если игрок выбрал "повторить игру", то сбрасываем состояние логики и конфигурации
         if (is_replay)
         {
-            logic = Logic(&board, &config); // пересоздаём объект логики
-            config.reload();                // перезагружаем настройки
+            // перезагружаем настройки: файл разбирается заново, только если он изменился;
+            // если новые настройки неверны, остаются прежние
+            if (!config.reload())
+                log_file.write("Error: settings are not reloaded. " + config.error() + "\n");
+            // пересоздаём объект логики с новыми настройками; неверные веса оценки сообщаются
+            // при запуске, а если файл весов испортили между партиями, остаётся прежняя логика
+            try
+            {
+                logic = Logic(&config);
+                logic.on_ponder_done = Hand::wake;
+            }
+            catch (const runtime_error& e)
+            {
+                log_file.write(string("Error: bot is not reloaded. ") + e.what() + "\n");
+            }
             board.redraw();                 // перерисовываем доску
         }
         else
         {
             board.start_draw();             // начальная отрисовка доски
+            hand.start();                   // SDL уже инициализирован, можно регистрировать события
         }
         is_replay = false;
+        ++game_num;
 
         int turn_num = -1;                  // номер хода (будет увеличен в цикле)
         bool is_quit = false;               // флаг выхода из игры
-        const int Max_turns = config("Game", "MaxNumTurns"); // максимальное число ходов
+        const bot_settings& bot = config.get().bot;
+        const int Max_turns = config.get().game.max_turns; // максимальное число ходов
 
         // основной игровой цикл
         while (++turn_num < Max_turns)
         {
             beat_series = 0;                // количество последовательных взятий
-            logic.find_turns(turn_num % 2); // ищем доступные ходы для текущего игрока
+            logic.find_turns(turn_num % 2, state.position()); // ищем доступные ходы для текущего игрока
 
             if (logic.turns.empty())        // если ходов нет — игра окончена
                 break;
 
             // устанавливаем глубину поиска для бота в зависимости от цвета
-            logic.Max_depth = config("Bot", string((turn_num % 2) ? "Black" : "White") + "BotLevel");
+            logic.Max_depth = bot.level[turn_num % 2];
 
             // если текущий игрок — человек
-            if (!config("Bot", string("Is") + string((turn_num % 2) ? "Black" : "White") + "Bot"))
+            if (!bot.is_bot[turn_num % 2])
             {
                 auto resp = player_turn(turn_num % 2); // обработка хода игрока
 
@@ -70,8 +92,7 @@ public:
                 else if (resp == Response::BACK)       // игрок отменил ход
                 {
                     // если предыдущий ход был бота и не было взятия — откатываем два хода
-                    if (config("Bot", string("Is") + string((1 - turn_num % 2) ? "Black" : "White") + "Bot") &&
-                        !beat_series && board.history_mtx.size() > 2)
+                    if (bot.is_bot[1 - turn_num % 2] && !beat_series && state.history_size() > 2)
                     {
                         board.rollback();
                         --turn_num;
@@ -89,15 +110,16 @@ public:
             else
             {
                 // ход делает бот
-                bot_turn(turn_num % 2);
+                bot_turn(turn_num);
             }
         }
+        // фоновый поиск бота больше не нужен
+        logic.stop_ponder();
 
         // фиксируем время окончания игры и записываем в лог
         auto end = chrono::steady_clock::now();
-        ofstream fout(project_path + "log.txt", ios_base::app);
-        fout << "Game time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
-        fout.close();
+        log_file.write("Game time: " + to_string((int)chrono::duration<double, milli>(end - start).count()) +
+                  " millisec\n");
 
         // если был запрос на повтор — запускаем игру заново
         if (is_replay)
@@ -133,53 +155,74 @@ public:
     }
 
 private:
-    void bot_turn(const bool color)
+    void bot_turn(const int turn_num)
     {
+        const bool color = turn_num % 2;
+        // показываем последний ход игрока до того, как бот начнёт думать
+        board.present();
         auto start = chrono::steady_clock::now();
 
-        auto delay_ms = config("Bot", "BotDelayMS");
+        const int delay_ms = config.get().bot.delay_ms;
         // new thread for equal delay for each turn
         thread th(SDL_Delay, delay_ms);
-        auto turns = logic.find_best_turns(color);
+        const full_turn turn = logic.find_best_turn(state.position(), color);
         th.join();
-        bool is_first = true;
-        // making moves
-        for (auto turn : turns)
+        // запись телеметрии копируется до ходов на доске и до пондеринга, который её перезапишет
+        search_record record = logic.telemetry;
+        record.game = game_num;
+        record.turn = turn_num;
+        // making moves: серия ударов показывается по одному удару
+        for (int i = 0; i < turn.count; ++i)
         {
-            if (!is_first)
+            if (i)
             {
                 SDL_Delay(delay_ms);
             }
-            is_first = false;
-            beat_series += (turn.xb != -1);
-            board.move_piece(turn, beat_series);
+            beat_series += turn.is_beat();
+            board.move_piece(turn.hop(i), beat_series);
+            board.present();
         }
 
         auto end = chrono::steady_clock::now();
-        ofstream fout(project_path + "log.txt", ios_base::app);
-        fout << "Bot turn time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
-        fout.close();
+        const double turn_ms = chrono::duration<double, milli>(end - start).count();
+        const bool from_book = logic.from_book, from_ponder = logic.from_ponder;
+        const tt_stats stats = logic.stats;
+        // строки лога собираются в потоке записи
+        log_file.post([turn_ms, from_book, from_ponder, stats, pv = record.pv](ostream& out) {
+            out << "Bot turn time: " << (int)turn_ms << " millisec\n";
+            out << (from_book ? "PV (book):" : (from_ponder ? "PV (ponder):" : "PV:"));
+            for (const auto& pv_turn : pv)
+                out << " " << pv_turn.notation();
+            out << "\n";
+            out << "TT hits: " << stats.hits << ", misses: " << stats.misses << ", collisions: " << stats.collisions
+                << "\n";
+        });
+        telemetry_log.post([record](ostream& out) { record.write_json(out); });
+
+        // пока думает человек, бот ищет ответ на его ожидаемый ход
+        if (!config.get().bot.is_bot[!color])
+            logic.start_ponder(state.position(), !color);
     }
 
     Response player_turn(const bool color)
     {
         // Формируем список клеток, с которых игрок может начать ход
         vector<pair<POS_T, POS_T>> cells;
-        for (auto turn : logic.turns)
+        for (const auto& turn : logic.turns)
         {
-            cells.emplace_back(turn.x, turn.y);
+            cells.emplace_back(turn.hop(0).x, turn.hop(0).y);
         }
 
         // Подсвечиваем клетки, доступные для выбора фигуры
         board.highlight_cells(cells);
 
-        // pos — выбранный игроком ход (пока пустой)
+        // pos — выбранный игроком первый шаг хода (пока пустой)
         move_pos pos = { -1, -1, -1, -1 };
 
         // x, y — координаты выбранной фигуры (первый клик)
         POS_T x = -1, y = -1;
 
-        // --- ЭТАП 1: выбор фигуры и конечной клетки для первого хода ---
+        // --- ЭТАП 1: выбор фигуры и конечной клетки для первого шага ---
         while (true)
         {
             // Получаем действие игрока: либо выбор клетки, либо BACK/QUIT/REPLAY
@@ -195,24 +238,25 @@ private:
             bool is_correct = false;
 
             // Проверяем: является ли клетка начальной точкой возможного хода
-            for (auto turn : logic.turns)
+            for (const auto& turn : logic.turns)
             {
+                const move_pos hop = turn.hop(0);
                 // Если игрок выбрал фигуру, с которой можно ходить
-                if (turn.x == cell.first && turn.y == cell.second)
+                if (hop.x == cell.first && hop.y == cell.second)
                 {
                     is_correct = true;
                     break;
                 }
 
                 // Если игрок уже выбрал фигуру, и теперь выбирает конечную клетку
-                if (turn == move_pos{ x, y, cell.first, cell.second })
+                if (hop == move_pos{ x, y, cell.first, cell.second })
                 {
-                    pos = turn; // найден корректный ход
+                    pos = hop; // найден корректный шаг
                     break;
                 }
             }
 
-            // Если найден полный ход — выходим из цикла
+            // Если найден шаг — выходим из цикла
             if (pos.x != -1)
                 break;
 
@@ -240,22 +284,23 @@ private:
             board.set_active(x, y);
 
             vector<pair<POS_T, POS_T>> cells2;
-            for (auto turn : logic.turns)
+            for (const auto& turn : logic.turns)
             {
-                if (turn.x == x && turn.y == y)
+                const move_pos hop = turn.hop(0);
+                if (hop.x == x && hop.y == y)
                 {
-                    cells2.emplace_back(turn.x2, turn.y2);
+                    cells2.emplace_back(hop.x2, hop.y2);
                 }
             }
 
             board.highlight_cells(cells2);
         }
 
-        // --- ЭТАП 2: выполнение первого хода ---
+        // --- ЭТАП 2: выполнение первого шага ---
         board.clear_highlight();
         board.clear_active();
 
-        // Делаем ход. Если xb != -1 — это взятие
+        // Делаем шаг. Если xb != -1 — это взятие
         board.move_piece(pos, pos.xb != -1);
 
         // Если не было взятия — ход завершён
@@ -265,20 +310,21 @@ private:
         // --- ЭТАП 3: серия обязательных взятий ---
         beat_series = 1;
 
-        while (true)
+        // Полные ходы, которые начинаются с уже сделанных шагов
+        vector<full_turn> series;
+        for (const auto& turn : logic.turns)
         {
-            // Ищем возможные продолжения взятия с новой позиции
-            logic.find_turns(pos.x2, pos.y2);
-
-            // Если больше нет взятий — серия закончена
-            if (!logic.have_beats)
-                break;
+            if (turn.hop(0) == pos)
+                series.push_back(turn);
+        }
 
+        for (int step = 1; series[0].count > step; ++step)
+        {
             // Подсвечиваем клетки, куда можно продолжить бить
             vector<pair<POS_T, POS_T>> cells;
-            for (auto turn : logic.turns)
+            for (const auto& turn : series)
             {
-                cells.emplace_back(turn.x2, turn.y2);
+                cells.emplace_back(turn.hop(step).x2, turn.hop(step).y2);
             }
 
             board.highlight_cells(cells);
@@ -295,23 +341,23 @@ private:
 
                 pair<POS_T, POS_T> cell{ get<1>(resp), get<2>(resp) };
 
-                bool is_correct = false;
-
-                // Проверяем, является ли выбранная клетка корректным продолжением взятия
-                for (auto turn : logic.turns)
+                // Оставляем только ходы, продолжающиеся в выбранную клетку
+                vector<full_turn> next;
+                for (const auto& turn : series)
                 {
-                    if (turn.x2 == cell.first && turn.y2 == cell.second)
+                    const move_pos hop = turn.hop(step);
+                    if (hop.x2 == cell.first && hop.y2 == cell.second)
                     {
-                        is_correct = true;
-                        pos = turn;
-                        break;
+                        pos = hop;
+                        next.push_back(turn);
                     }
                 }
 
-                if (!is_correct)
+                if (next.empty())
                     continue; // ждём корректный выбор
 
                 // Делаем очередное взятие
+                series.swap(next);
                 board.clear_highlight();
                 board.clear_active();
                 beat_series += 1;
@@ -327,9 +373,15 @@ private:
 
 private:
     Config config;
+    State state;
     Board board;
     Hand hand;
     Logic logic;
+    // log.txt и структурированный лог телеметрии (TelemetryPath), пишутся в фоновых потоках
+    Async_log log_file;
+    Async_log telemetry_log;
     int beat_series;
     bool is_replay = false;
+    // номер партии с запуска, для телеметрии
+    int game_num = 0;
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "Board.h"
 
 // Класс, отвечающий за обработку действий игрока (мышь, закрытие окна и т.п.)
+// Ожидание блокирующее (SDL_WaitEvent): пока игрок ничего не делает, процессор не занят.
+// Движок может разбудить ожидание из своего потока через wake().
 class Hand
 {
 public:
@@ -13,6 +15,26 @@ public:
     {
     }
 
+    // Регистрирует тип события движка. Вызывается после Board::start_draw, где
+    // инициализируется SDL; до этого wake() ничего не делает.
+    void start()
+    {
+        if (engine_event == Uint32(-1))
+            engine_event = SDL_RegisterEvents(1);
+    }
+
+    // Будит ожидание ввода из любого потока, например когда закончился фоновый поиск бота.
+    // Ожидание продолжается, но игра успевает проверить состояние движка.
+    static void wake()
+    {
+        if (engine_event == Uint32(-1))
+            return;
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = engine_event;
+        SDL_PushEvent(&event);
+    }
+
     // Ожидание выбора клетки игроком.
     // Возвращает: тип действия (Response) + координаты клетки (xc, yc)
     tuple<Response, POS_T, POS_T> get_cell() const
@@ -24,8 +46,8 @@ public:
 
         while (true)
         {
-            // Проверяем, произошло ли событие
-            if (SDL_PollEvent(&windowEvent))
+            // Ждём события, не занимая процессор
+            if (next_event(windowEvent))
             {
                 switch (windowEvent.type)
                 {
@@ -45,7 +67,7 @@ public:
                     yc = int(x / (board->W / 10) - 1);
 
                     // Клик по кнопке "Назад"
-                    if (xc == -1 && yc == -1 && board->history_mtx.size() > 1)
+                    if (xc == -1 && yc == -1 && board->state->history_size() > 1)
                     {
                         resp = Response::BACK;
                     }
@@ -94,7 +116,7 @@ public:
 
         while (true)
         {
-            if (SDL_PollEvent(&windowEvent))
+            if (next_event(windowEvent))
             {
                 switch (windowEvent.type)
                 {
@@ -103,9 +125,10 @@ public:
                     resp = Response::QUIT;
                     break;
 
-                case SDL_WINDOWEVENT_SIZE_CHANGED:
+                case SDL_WINDOWEVENT:
                     // Пересчёт размеров доски при изменении окна
-                    board->reset_window_size();
+                    if (windowEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                        board->reset_window_size();
                     break;
 
                 case SDL_MOUSEBUTTONDOWN: {
@@ -130,5 +153,29 @@ public:
     }
 
 private:
+    // Ждёт следующего события. Перед ожиданием показывает накопленные изменения доски;
+    // если их пока рано показывать (кадр ещё не прошёл), ждёт не дольше начала следующего кадра.
+    // Потерю текстур (сброс устройства рендера) обрабатывает сам.
+    // Возвращает false, если за это время событий не было.
+    bool next_event(SDL_Event& event) const
+    {
+        const int wait_ms = board->flush();
+        const bool has_event = wait_ms < 0 ? SDL_WaitEvent(&event) : SDL_WaitEventTimeout(&event, wait_ms);
+        if (has_event && event.type == SDL_RENDER_TARGETS_RESET)
+        {
+            board->reset_window_size();
+            return false;
+        }
+        // Устройство рендера пересоздано: все текстуры потеряны
+        if (has_event && event.type == SDL_RENDER_DEVICE_RESET)
+        {
+            board->reload_textures();
+            return false;
+        }
+        return has_event;
+    }
+
     Board* board; // указатель на игровую доску (нужен для вычисления координат и пересчёта размеров)
+    // Тип пользовательского события SDL, которым движок будит ожидание (-1 — ещё не зарегистрирован)
+    inline static Uint32 engine_event = Uint32(-1);
 };
\ No newline at end of file
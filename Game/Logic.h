@@ -1,362 +1,772 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "../Models/Move.h"
-#include "Board.h"
+#include "../Models/Move_list.h"
+#include "../Models/Position.h"
 #include "Config.h"
+#include "Evaluator.h"
+#include "Opening_book.h"
+#include "Rules.h"
+#include "Tablebase.h"
+#include "Telemetry.h"
+#include "Transposition_table.h"
 
 const int INF = 1e9;
 
+// Максимальная глубина, для которой хранятся killer-ходы и главная линия
+const int MAX_PLY = 64;
+
+// Оценки из таблиц эндшпиля лежат в полосе шириной TB_SCORE_RANGE у ±INF (см. tb_score)
+const int TB_SCORE_RANGE = 1000;
+
+// Фоновый поиск ответа бота, пока думает человек (пондеринг).
+// Удаление задачи прерывает поиск и дожидается потока.
+struct ponder_task
+{
+    Position pos;               // ожидаемая позиция: после хода бота и предсказанного ответа человека
+    bool color = false;         // сторона бота
+    atomic<bool> stopped{false};
+    bool done = false;          // поиск закончился сам, защищено done_mutex
+    mutex done_mutex;
+    condition_variable done_cv;
+    thread worker;
+
+    ~ponder_task()
+    {
+        stopped = true;
+        if (worker.joinable())
+            worker.join();
+    }
+};
+
+// Состояние одного потока поиска. Всё, что меняется в рекурсии, лежит здесь,
+// поэтому несколько потоков могут искать одновременно на общей таблице транспозиций.
+struct search_state
+{
+    // Глубина текущей итерации углубления (не больше Max_depth)
+    size_t depth = 0;
+    // Количество посещённых узлов
+    size_t nodes = 0;
+    // Счётчики обращений к таблице транспозиций
+    tt_stats stats;
+    // Счётчики телеметрии, включённые при сборке (см. Telemetry.h)
+    search_counters counters;
+    // Общий для всех потоков флаг прерывания поиска по времени
+    atomic<bool>* stopped = nullptr;
+    // Момент, после которого поиск прерывается
+    chrono::steady_clock::time_point deadline;
+    // Killer-ходы: два последних тихих хода, давших отсечение на этой глубине
+    full_turn killers[MAX_PLY][2];
+    // Эвристика истории: вес тихого хода [откуда][куда], растёт при каждом отсечении
+    int history[32][32] = {};
+    // Треугольная таблица главной линии: pv[d] — лучшая линия из узла глубины d,
+    // pv_length[d] — её длина. Строка d собирается из хода узла и строки d + 1.
+    full_turn pv[MAX_PLY][MAX_PLY];
+    int pv_length[MAX_PLY] = {};
+    // Главная линия прошлой итерации углубления и ключи позиций перед каждым её ходом:
+    // в узле на этой линии её ход проверяется первым. Индекс 0 — ход корня.
+    full_turn prev_pv[MAX_PLY];
+    uint64_t prev_pv_hash[MAX_PLY] = {};
+    int prev_pv_length = 0;
+};
+
 class Logic
 {
   public:
-    Logic(Board *board, Config *config) : board(board), config(config)
+    // Логика не зависит от SDL и Board: позиция передаётся в каждый вызов,
+    // поэтому её можно использовать без окна (см. Tools/headless.cpp).
+    Logic(const Config* config) : config(config)
     {
-        optimization = (*config)("Bot", "Optimization");
+        const bot_settings& bot = config->get().bot;
+        optimization = bot.optimization;
+        tt.resize(bot.table_size_mb);
+        time_limit_ms = bot.time_limit_ms;
+        no_random = bot.no_random;
+        evaluator.load(project_path + bot.eval_weights_path);
+        evaluator.set_scoring_type(bot.scoring_type);
+        threads = bot.threads;
+        if (threads <= 0)
+            threads = max(1, int(thread::hardware_concurrency()));
+        if (bot.tablebase_pieces > 0)
+            tablebase.load(project_path + bot.tablebase_path, bot.tablebase_pieces);
+        if (!bot.book_path.empty())
+            book.load(project_path + bot.book_path);
+        book_weighted = bot.book_selection == Book_selection::WEIGHTED;
+        ponder_enabled = bot.ponder;
     }
 
-    vector<move_pos> find_best_turns(const bool color) {
-        next_move.clear();
-        next_best_state.clear();
+    // Поиск ровно до Max_depth: без лимита времени, дебютной книги и таблиц эндшпиля.
+    // Тогда число узлов зависит только от позиции и поиска (сравнение в Tools/headless.cpp).
+    void search_fixed_depth()
+    {
+        time_limit_ms = 0;
+        book.close();
+        tablebase.close();
+    }
 
-        find_first_best_turn(board->get_board(), color, -1, -1, 0);
+    // Пондеринг: после хода бота, пока думает человек, в фоновом потоке ищется ответ
+    // на ход человека, предсказанный главной линией (pv[1]).
+    // pos — позиция после хода бота, color — сторона человека. Вызывается сразу после
+    // find_best_turn, до него pv не меняется. Если человек сыграет предсказанный ход,
+    // find_best_turn возьмёт готовый результат, иначе поиск прервётся,
+    // а найденное им останется в таблице транспозиций.
+    void start_ponder(const Position& pos, const bool color)
+    {
+        stop_ponder();
+        if (!ponder_enabled || pv.size() < 2)
+            return;
+        move_list replies;
+        find_turns(color, pos, replies);
+        if (find(replies.begin(), replies.end(), pv[1]) == replies.end())
+            return;
+        ponder = make_unique<ponder_task>();
+        ponder->pos = pos;
+        ponder->pos.make_turn(pv[1]);
+        ponder->color = !color;
+        ponder->worker = thread([this, task = ponder.get(), depth = Max_depth]() {
+            search(task->pos, task->color, depth, task->stopped, false);
+            {
+                lock_guard<mutex> lock(task->done_mutex);
+                task->done = true;
+                task->done_cv.notify_all();
+            }
+            if (on_ponder_done && !task->stopped)
+                on_ponder_done();
+        });
+    }
 
-        vector<move_pos> res;
-        int state = 0;
-        do
-        {
-           res.push_back(next_move[state]);
-           state = next_best_state[state];
-        } 
-        while (state != -1 && next_move[state].x != -1);
+    // Прерывает фоновый поиск, если он идёт
+    void stop_ponder()
+    {
+        ponder.reset();
+    }
+
+    // Итеративное углубление: поиск на глубину 0, 1, ..., Max_depth.
+    // Если задан BotTimeLimitMS, поиск прерывается по времени и
+    // возвращается лучший ход последней полностью завершённой итерации.
+    // Главная линия предыдущей итерации проверяется первой, в остальных узлах
+    // первым идёт лучший ход из таблицы транспозиций.
+    // Возвращает полный ход, серия ударов выбирается целиком; вся главная линия — в pv.
+    // Позиции из дебютной книги и выигранные или проигранные позиции из таблиц эндшпиля
+    // не ищутся вовсе.
+    // Если для этой позиции идёт пондеринг, берётся его результат: поиск доводится
+    // до Max_depth, но не дольше BotTimeLimitMS.
+    full_turn find_best_turn(const Position& pos, const bool color)
+    {
+        const auto start = chrono::steady_clock::now();
+        const full_turn res = find_best_turn_timed(pos, color);
+        telemetry.time_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
         return res;
     }
 
    private:
-    double find_first_best_turn(vector<vector<POS_T>> mtx, const bool color, const POS_T x, const POS_T y, size_t state,
-        double alpha = -1) {
-        next_move.emplace_back(-1, -1, -1, -1);
-        next_best_state.push_back(-1);
-        if (state !=0)
-        {
-            find_turns(x, y, mtx);
-        }
-        auto now_turns = turns;
-        auto now_have_beats = have_beats;
-
-        if (!now_have_beats && state != 0)
+    // find_best_turn без замера времени хода
+    full_turn find_best_turn_timed(const Position& pos, const bool color)
+    {
+        from_ponder = false;
+        if (ponder && ponder->pos == pos && ponder->color == color)
         {
-            return find_best_turns_rec(mtx, 1 - color, 0, alpha);
-        }
-        double best_score = -1;
-        for (auto turn : now_turns) {
-            size_t new_state = next_move.size();
-            double score;
-            if (now_have_beats) {
-                score =  find_first_best_turn(make_turn(mtx, turn), color, turn.x2, turn.y2, new_state, best_score);
-            }
-            else {
-                score = find_best_turns_rec(make_turn(mtx, turn), 1 - color, 0, best_score);
+            {
+                unique_lock<mutex> lock(ponder->done_mutex);
+                auto is_done = [this]() { return ponder->done; };
+                if (time_limit_ms)
+                    ponder->done_cv.wait_for(lock, chrono::milliseconds(time_limit_ms), is_done);
+                else
+                    ponder->done_cv.wait(lock, is_done);
             }
-            if (score > best_score) {
-                best_score = score;
-                next_move[state] = turn;
-                next_best_state[state] = (now_have_beats ? new_state : -1);
+            stop_ponder();
+            from_ponder = !pv.empty();
+            if (from_ponder)
+            {
+                telemetry.source = "ponder";
+                return pv[0];
             }
         }
-        return best_score;
+        stop_ponder();
+        atomic<bool> stopped(false);
+        return search(pos, color, Max_depth, stopped, true);
     }
 
-    double find_best_turns_rec(vector<vector<POS_T>> mtx, const bool color, const size_t depth, double alpha = -1,
-        double beta = INF + 1, const POS_T x = -1, const POS_T y = -1) {
-        if (depth == Max_depth) {
-            return calc_score(mtx, (depth % 2 == color));
-        }
-        if (x != -1) {
-            find_turns(x, y, mtx);
-        }
-        else
+    // Итеративное углубление до max_depth с общим для потоков флагом прерывания stopped.
+    // timed — действует BotTimeLimitMS (пондеринг идёт без лимита, пока его не прервут).
+    // Результат пишется в pv, nodes, stats, score, from_book и telemetry.
+    full_turn search(const Position& root, const bool color, const int max_depth, atomic<bool>& stopped,
+                     const bool timed)
+    {
+        const auto start = chrono::steady_clock::now();
+        // Счётчики позиции и всех её копий в поиске считают таблицы клеток этой оценки
+        Position pos = root;
+        evaluator.attach(pos);
+        telemetry = search_record();
+        telemetry.color = color;
+        telemetry.level = max_depth;
+        move_list root_turns;
+        find_turns(color, pos, root_turns);
+        pv.clear();
+        nodes = 0;
+        score = 0;
+        stats = tt_stats();
+        from_book = probe_book(pos, color, root_turns);
+        if (from_book || probe_root(pos, color, root_turns))
         {
-            find_turns(color, mtx);
-        }
-        auto now_turns = turns;
-        auto now_have_beats = have_beats;
-        if (!now_have_beats && x != -1) {
-            return find_best_turns_rec(mtx, 1 - color, depth + 1, alpha, beta);
+            finish_telemetry(from_book ? "book" : "tablebase", -1, search_counters(), start);
+            return pv[0];
         }
 
-        if (turns.empty()) {
-            return (depth % 2 ? 0 : INF);
+        tt.new_search();
+        vector<search_state> states(threads);
+        for (auto& st : states)
+        {
+            st.stopped = &stopped;
+            st.deadline = timed ? chrono::steady_clock::now() + chrono::milliseconds(time_limit_ms)
+                                : chrono::steady_clock::time_point::max();
         }
 
-        double min_score = INF + 1;
-        double max_score = - 1;
-        for (auto turn : now_turns) {
-            double score;
-            if (now_have_beats) {
-                score = find_best_turns_rec(make_turn(mtx, turn), color, depth, alpha, beta, turn.x2, turn.y2);
-            }
-            else
+        int depth_done = -1;
+        for (size_t depth = 0; depth <= size_t(max_depth); ++depth)
+        {
+            if (!pv.empty())
             {
-                score = find_best_turns_rec(make_turn(mtx, turn), 1 - color, depth + 1, alpha, beta);
+                // Лучший ход предыдущей итерации — первым
+                auto it = find(root_turns.begin(), root_turns.end(), pv[0]);
+                if (it != root_turns.end())
+                    rotate(root_turns.begin(), it, it + 1);
             }
-            min_score = min(min_score, score);
-            max_score = max(max_score, score);
+            for (auto& st : states)
+                st.depth = depth;
+            double line_score;
+            auto line = search_root(pos, color, root_turns, states, line_score);
+            if (stopped)
+                break;
+            pv = line;
+            score = line_score;
+            depth_done = int(depth);
+            seed_pv(pos, states);
 
-            if (depth % 2)
-            {
-                alpha = max(alpha, max_score);
-            }
-            else {
-                beta = min(beta, min_score);
-            }
-            if (optimization != "O0" && alpha > beta) {
+            if (time_limit_ms && chrono::steady_clock::now() >= states[0].deadline)
                 break;
-            }
-            if (optimization == "O2" && alpha == beta) {
-                return (depth % 2 ? max_score +1 : min_score - 1);
-            }
         }
-        return (depth % 2 ? max_score : min_score);
+
+        search_counters counters;
+        for (const auto& st : states)
+        {
+            nodes += st.nodes;
+            stats += st.stats;
+            counters += st.counters;
+        }
+        finish_telemetry("search", depth_done, counters, start);
+        return pv.empty() ? full_turn() : pv[0];
+    }
+
+    // Итоги поиска в telemetry: откуда ход, глубина, счётчики, линия и время
+    void finish_telemetry(const char* source, const int depth, const search_counters& counters,
+                          const chrono::steady_clock::time_point start)
+    {
+        telemetry.source = source;
+        telemetry.depth = depth;
+        telemetry.nodes = nodes;
+        telemetry.counters = counters;
+        telemetry.tt = stats;
+        telemetry.score = score;
+        telemetry.pv = pv;
+        telemetry.search_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
     }
 
-    // Оценивает текущее состояние доски для бота. 
-    // Параметры: 
-    // mtx — матрица доски. 
-    // first_bot_color — цвет бота (true = белые, false = чёрные). /// 
-    // Алгоритм: 
-    // 1. Подсчитываем количество обычных и дамочных шашек каждого цвета. 
-    // 2. Если включён режим NumberAndPotential — добавляем небольшой бонус за продвижение обычных шашек вперёд. 
-    // 3. Если бот играет чёрными — меняем местами счётчики, чтобы "w" всегда означало фигуры бота. 
-    // 4. Если у бота нет фигур — возвращаем INF (проигрыш). 
-    // 5. Если у соперника нет фигур — возвращаем 0 (победа). 
-    // 6. Возвращаем отношение силы соперника к силе бота: (b + bq * q_coef) / (w + wq * q_coef)  Чем меньше значение — тем лучше позиция для бота.
-
-    double calc_score(const vector<vector<POS_T>>& mtx, const bool first_bot_color) const
+    // Ход из дебютной книги: при BookSelection = "Weighted" случайный с вероятностью,
+    // пропорциональной весу, иначе (и при NoRandom) ход с наибольшим весом.
+    // Ход записывается в pv, false — позиции в книге нет.
+    bool probe_book(const Position& pos, const bool color, const move_list& root_turns)
     {
-        // color - who is max player
-        double w = 0, wq = 0, b = 0, bq = 0;
+        vector<full_turn> moves;
+        vector<int> weights;
+        if (!book.probe(pos, color, root_turns, moves, weights))
+            return false;
+        size_t choice = max_element(weights.begin(), weights.end()) - weights.begin();
+        if (book_weighted && !no_random)
+            choice = discrete_distribution<size_t>(weights.begin(), weights.end())(rand_eng);
+        pv.assign(1, moves[choice]);
+        return true;
+    }
 
-        // Подсчёт фигур
-        for (POS_T i = 0; i < 8; ++i)
+    // Корень в таблицах эндшпиля. Выигрыш и проигрыш разыгрываются без поиска:
+    // самый быстрый выигрыш или самый долгий проигрыш, ход записывается в pv и возвращается true.
+    // В ничейной позиции в root_turns остаются только ходы, сохраняющие ничью, и поиск
+    // выбирает среди них тот, где сопернику легче ошибиться.
+    bool probe_root(const Position& root, const bool color, move_list& root_turns)
+    {
+        uint8_t value;
+        if (root_turns.empty() || !tablebase.probe(root, color, value))
+            return false;
+        Position pos = root;
+        double best_score = -INF - 1;
+        int best_index = -1;
+        move_list draws;
+        for (int i = 0; i < root_turns.size(); ++i)
         {
-            for (POS_T j = 0; j < 8; ++j)
+            uint8_t child;
+            const turn_undo undo = pos.make_turn(root_turns[i]);
+            const bool found = tablebase.probe(pos, !color, child);
+            pos.unmake_turn(root_turns[i], undo);
+            if (!found)
+                return false;
+            const double score = -tb_score(child, 1);
+            if (score > best_score)
             {
-                w += (mtx[i][j] == 1);   // белые
-                wq += (mtx[i][j] == 3);  // белые дамки
-                b += (mtx[i][j] == 2);   // чёрные
-                bq += (mtx[i][j] == 4);  // чёрные дамки
+                best_score = score;
+                best_index = i;
             }
+            if (child == TB_DRAW)
+                draws.push_back(root_turns[i]);
         }
-        // Если бот играет чёрными — меняем местами значения, 
-        // чтобы "w" всегда означало фигуры бота.
-        if (!first_bot_color)
+        if (value != TB_DRAW)
         {
-            swap(b, w);
-            swap(bq, wq);
+            pv.assign(1, root_turns[best_index]);
+            score = best_score;
+            return true;
         }
-        // Если у белых нет фигур — проигрыш
-        if (w + wq == 0)
-            return INF;
-        // Если у черных нет фигур — победа
-        if (b + bq == 0)
-            return 0;
-        // Коэффициент для дамок
-        int q_coef = 4;
-        // Возвращает отношение силы соперника к силе бота
-        return (b + bq * q_coef) / (w + wq * q_coef);
+        draws.have_beats = root_turns.have_beats;
+        root_turns = draws;
+        return false;
     }
 
-    // Выполняет ход на копии матрицы доски. 
-        // Алгоритм: 
-        // 1. Если ход является ударом (xb != -1) — снимаем побитую шашку. 
-        // 2. Проверяем, превращается ли шашка в дамку:
-        // - белая (1) становится дамкой (3), если дошла до 0-й строки. 
-        // - чёрная (2) становится дамкой (4), если дошла до 7-й строки. 
-        // 3. Перемещаем шашку на новую позицию. 
-        // 4. Освобождаем старую клетку. 
-        // Возвращает: новую матрицу после хода.
-    vector<vector<POS_T>> make_turn(vector<vector<POS_T>> mtx, move_pos turn) const
+    // Поиск на корне, ходы корня делятся между потоками.
+    // Каждый поток берёт следующий ход из общего счётчика и ищет его с текущей лучшей
+    // оценкой в качестве alpha. Оценка выше alpha точная, из равных выбирается ход
+    // с меньшим номером: для хода левее текущего лучшего alpha чуть понижается,
+    // чтобы равная оценка тоже оказалась точной. Поэтому результат не зависит
+    // от того, какой поток какой ход посчитал, и совпадает с полным перебором.
+    // Возвращает главную линию: лучший ход корня и ответы на него, оценка лучшего хода — в score.
+    vector<full_turn> search_root(const Position& root, const bool color, const move_list& root_turns,
+                                  vector<search_state>& states, double& score)
     {
-        // Если xb != -1 — это удар, удаляем побитую шашку
-        if (turn.xb != -1)
-            mtx[turn.xb][turn.yb] = 0;
-        // Проверка превращения в дамку 
-        // 1 → 3 (белая → белая дамка), если дошла до верхней строки 
-        // 2 → 4 (чёрная → чёрная дамка), если дошла до нижней строки
-        if ((mtx[turn.x][turn.y] == 1 && turn.x2 == 0) || (mtx[turn.x][turn.y] == 2 && turn.x2 == 7))
-            mtx[turn.x][turn.y] += 2;
-        // Перемещаем шашку на новую клетку
-        mtx[turn.x2][turn.y2] = mtx[turn.x][turn.y];
-        // Освобождаем старую клетку
-        mtx[turn.x][turn.y] = 0;
-        return mtx;
-    }
-
-public:
-    // Находит все возможные ходы для заданного цвета. 
-    // color Цвет игрока (0 или 1), для которого нужно найти ходы. 
-    // Функция вызывает перегруженную версию find_turns, передавая текущее состояние доски из объекта Board. 
+        mutex result_mutex;
+        double best_score = -INF - 1;
+        int best_index = -1;
+        vector<full_turn> best_line;
+        atomic<int> next_index(0);
 
-    void find_turns(const bool color)
-    {
-        find_turns(color, board->get_board());
-    }
+        auto worker = [&](search_state& st) {
+            Position pos = root;
+            while (true)
+            {
+                const int i = next_index++;
+                if (i >= root_turns.size())
+                    break;
+                const full_turn& turn = root_turns[i];
+                double alpha;
+                int alpha_index;
+                {
+                    lock_guard<mutex> lock(result_mutex);
+                    alpha = best_score;
+                    alpha_index = best_index;
+                }
+                if (alpha_index > i)
+                    alpha = nextafter(alpha, -INF - 1);
+                double score;
+                if (optimization == Optimization::O2 && alpha_index != -1)
+                {
+                    // PVS: сначала проверяем нулевым окном, что ход лучше alpha
+                    score = search_turn(st, pos, color, 0, turn, alpha, nextafter(alpha, INF + 1));
+                    if (score > alpha && !*st.stopped)
+                        score = search_turn(st, pos, color, 0, turn, alpha, INF + 1);
+                }
+                else
+                {
+                    score = search_turn(st, pos, color, 0, turn, alpha, INF + 1);
+                }
+                if (*st.stopped)
+                    break;
+                if (optimization != Optimization::O0 && score <= alpha)
+                    continue;
 
-    // @brief Находит все возможные ходы для конкретной шашки по координатам X, Y
-    // Функция вызывает find_turns, используя текущее состояние доски. 
+                lock_guard<mutex> lock(result_mutex);
+                if (score > best_score || (score == best_score && i < best_index))
+                {
+                    best_score = score;
+                    best_index = i;
+                    best_line.assign(1, turn);
+                    best_line.insert(best_line.end(), st.pv[0], st.pv[0] + st.pv_length[0]);
+                }
+            }
+        };
 
-    void find_turns(const POS_T x, const POS_T y)
-    {
-        find_turns(x, y, board->get_board());
+        vector<thread> pool;
+        for (size_t i = 1; i < states.size(); ++i)
+            pool.emplace_back(worker, ref(states[i]));
+        worker(states[0]);
+        for (auto& th : pool)
+            th.join();
+        score = best_score;
+        return best_line;
     }
 
-    // Находит все возможные ходы для всех шашек указанного цвета.
-    // Алгоритм: 
-    // 1. Обходит все клетки доски. 
-    // 2. Для каждой шашки нужного цвета вызывает find_turns.
-    // 3. Если хотя бы одна шашка может бить — сохраняются только бьющие ходы. 
-    // 4. Если бить нельзя — сохраняются обычные ходы.
-    // 5. Ходы перемешиваются для рандомизации поведения бота. 
-    // Результат: список всех возможных ходов. 
-
-private:
-    void find_turns(const bool color, const vector<vector<POS_T>> &mtx)
+    // Запоминает главную линию pv во всех потоках для упорядочивания следующей итерации
+    void seed_pv(const Position& root, vector<search_state>& states) const
     {
-        vector<move_pos> res_turns;
-        bool have_beats_before = false;
-        for (POS_T i = 0; i < 8; ++i)
+        Position pos = root;
+        const int length = min(int(pv.size()), MAX_PLY);
+        for (int i = 0; i < length; ++i)
         {
-            for (POS_T j = 0; j < 8; ++j)
+            for (auto& st : states)
             {
-                if (mtx[i][j] && mtx[i][j] % 2 != color)
-                {
-                    find_turns(i, j, mtx);
-                    if (have_beats && !have_beats_before)
-                    {
-                        have_beats_before = true;
-                        res_turns.clear();
-                    }
-                    if ((have_beats_before && have_beats) || !have_beats_before)
-                    {
-                        res_turns.insert(res_turns.end(), turns.begin(), turns.end());
-                    }
-                }
+                st.prev_pv[i] = pv[i];
+                st.prev_pv_hash[i] = pos.hash;
             }
+            pos.make_turn(pv[i]);
         }
-        turns = res_turns;
-        have_beats = have_beats_before;
+        for (auto& st : states)
+            st.prev_pv_length = length;
     }
 
-    // Находит все возможные ходы для одной конкретной шашки
-    // Алгоритм: 
-    // 1. Определяет тип фигуры (обычная шашка или дамка). 
-    // 2. Сначала ищет ВСЕ возможные удары: 
-    // - Для обычных шашек: проверяет клетки через одну. 
-    // - Для дамок: ищет удар на любой дистанции по диагонали. 
-    // 3. Если удары найдены — обычные ходы НЕ рассматриваются. 
-    // 4. Если ударов нет — ищет обычные ходы: 
-    // - Для обычных шашек: один шаг вперёд по диагонали. 
-    // - Для дамок: любое количество клеток по диагонали.
-    // Результат: 
-    // - turns — список всех ходов этой шашки. 
-    // - have_beats — true, если найден хотя бы один удар.
-
-    void find_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx)
-    {
-        turns.clear();
-        have_beats = false;
-        POS_T type = mtx[x][y];
-        // check beats
-        switch (type)
+    // Negamax с альфа-бета отсечением (fail-soft).
+    // Оценка считается для стороны color, которая сейчас ходит: ход соперника
+    // оценивается как минус его оценка с окном (-beta, -alpha).
+    // Оценка внутри окна (alpha, beta) точная, не больше alpha — верхняя граница,
+    // не меньше beta — нижняя граница. При O0 отсечений нет, все оценки точные.
+    // При O2 все ходы после первого сначала проверяются нулевым окном (PVS)
+    // и пересчитываются с полным окном, только если оказались лучше alpha.
+    // Серия ударов — один полный ход, поэтому глубина растёт на каждом ходе.
+    double find_best_turns_rec(search_state& st, Position& pos, const bool color, const size_t depth,
+        double alpha, const double beta) {
+        if (is_time_up(st))
+            return 0;
+        if (depth < MAX_PLY)
+            st.pv_length[depth] = 0;
+        uint8_t tb_value;
+        if (tablebase.probe(pos, color, tb_value))
         {
-        case 1:
-        case 2:
-            // check pieces
-            for (POS_T i = x - 2; i <= x + 2; i += 4)
+            telemetry_add<TM_TB_HITS>(st.counters.tb_hits);
+            return tb_score(tb_value, depth + 1);
+        }
+        if (depth == st.depth) {
+            return quiescence(st, pos, color, depth + 1, alpha, beta);
+        }
+        move_list now_turns;
+        find_turns(color, pos, now_turns);
+
+        // Нет ходов — проигрыш ходящей стороны
+        if (now_turns.empty()) {
+            return -INF;
+        }
+
+        // Таблица транспозиций.
+        // При NoRandom используется только запись ровно нужной глубины,
+        // чтобы оценка не зависела от того, что успели записать другие потоки.
+        const int rest_depth = int(st.depth - depth);
+        const uint64_t key = tt_key(pos, color);
+        const double alpha_start = alpha;
+        tt_entry entry;
+        if (tt.probe(key, entry, st.stats))
+        {
+            entry.score = score_from_tt(entry.score, depth + 1);
+            if (no_random ? entry.depth == rest_depth : entry.depth >= rest_depth)
             {
-                for (POS_T j = y - 2; j <= y + 2; j += 4)
+                if (entry.bound == Bound::EXACT ||
+                    (optimization != Optimization::O0 && entry.bound == Bound::LOWER && entry.score >= beta) ||
+                    (optimization != Optimization::O0 && entry.bound == Bound::UPPER && entry.score <= alpha))
                 {
-                    if (i < 0 || i > 7 || j < 0 || j > 7)
-                        continue;
-                    POS_T xb = (x + i) / 2, yb = (y + j) / 2;
-                    if (mtx[i][j] || !mtx[xb][yb] || mtx[xb][yb] % 2 == type % 2)
-                        continue;
-                    turns.emplace_back(x, y, i, j, xb, yb);
+                    return entry.score;
                 }
             }
-            break;
-        default:
-            // check queens
-            for (POS_T i = -1; i <= 1; i += 2)
+        }
+        order_turns(st, pos, now_turns, depth, entry.best_from, entry.best_to);
+
+        double best_score = -INF - 1;
+        full_turn best_turn;
+        for (int i = 0; i < now_turns.size(); ++i) {
+            const full_turn& turn = now_turns[i];
+            double score;
+            if (optimization == Optimization::O2 && i > 0)
             {
-                for (POS_T j = -1; j <= 1; j += 2)
+                score = search_turn(st, pos, color, depth + 1, turn, alpha, nextafter(alpha, INF + 1));
+                if (score > alpha && score < beta && !*st.stopped)
+                    score = search_turn(st, pos, color, depth + 1, turn, alpha, beta);
+            }
+            else
+            {
+                score = search_turn(st, pos, color, depth + 1, turn, alpha, beta);
+            }
+            if (*st.stopped)
+                return 0;
+            if (score > best_score)
+            {
+                best_score = score;
+                best_turn = turn;
+                update_pv(st, depth, turn);
+            }
+            if (optimization != Optimization::O0)
+            {
+                alpha = max(alpha, score);
+                if (alpha >= beta)
                 {
-                    POS_T xb = -1, yb = -1;
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                        {
-                            if (mtx[i2][j2] % 2 == type % 2 || (mtx[i2][j2] % 2 != type % 2 && xb != -1))
-                            {
-                                break;
-                            }
-                            xb = i2;
-                            yb = j2;
-                        }
-                        if (xb != -1 && xb != i2)
-                        {
-                            turns.emplace_back(x, y, i2, j2, xb, yb);
-                        }
-                    }
+                    telemetry_add<TM_CUTOFFS>(st.counters.cutoffs);
+                    if (i == 0)
+                        telemetry_add<TM_FIRST_CUTOFFS>(st.counters.first_cutoffs);
+                    // Тихий ход, давший отсечение, запоминаем для упорядочивания соседних узлов
+                    if (!turn.is_beat())
+                        add_killer(st, turn, depth, rest_depth);
+                    break;
                 }
             }
-            break;
         }
-        // check other turns
-        if (!turns.empty())
+        Bound bound = Bound::EXACT;
+        if (optimization != Optimization::O0 && best_score >= beta)
+            bound = Bound::LOWER;
+        else if (optimization != Optimization::O0 && best_score <= alpha_start)
+            bound = Bound::UPPER;
+        tt.store(key, score_to_tt(best_score, depth + 1), rest_depth, bound, best_turn);
+        return best_score;
+    }
+
+    // Поиск после номинальной глубины: перебираются только удары, пока позиция
+    // не станет спокойной. Бить обязательно, поэтому при наличии удара оценка
+    // позиции «как есть» не используется, а берётся лучшая из серий ударов.
+    // Каждый удар снимает фигуру, поэтому поиск конечен. Таблица не используется.
+    // ply — расстояние узла от корня в полуходах (для оценок из таблиц эндшпиля).
+    double quiescence(search_state& st, Position& pos, const bool color, const size_t ply, double alpha,
+                      const double beta)
+    {
+        if (is_time_up(st))
+            return 0;
+        telemetry_add<TM_QNODES>(st.counters.qnodes);
+        uint8_t tb_value;
+        if (tablebase.probe(pos, color, tb_value))
         {
-            have_beats = true;
-            return;
+            telemetry_add<TM_TB_HITS>(st.counters.tb_hits);
+            return tb_score(tb_value, ply);
         }
-        switch (type)
+        move_list now_turns;
+        find_turns(color, pos, now_turns);
+        if (!now_turns.have_beats)
         {
-        case 1:
-        case 2:
-            // check pieces
+            if (now_turns.empty())
+                return -INF;
+            telemetry_add<TM_EVALS>(st.counters.evals);
+            return calc_score(pos, color);
+        }
+        order_turns(st, pos, now_turns, st.depth, -1, -1);
+
+        double best_score = -INF - 1;
+        for (const auto& turn : now_turns)
+        {
+            const turn_undo undo = pos.make_turn(turn);
+            const double score = -quiescence(st, pos, 1 - color, ply + 1, -beta, -alpha);
+            pos.unmake_turn(turn, undo);
+            if (*st.stopped)
+                return 0;
+            best_score = max(best_score, score);
+            if (optimization != Optimization::O0)
             {
-                POS_T i = ((type % 2) ? x - 1 : x + 1);
-                for (POS_T j = y - 1; j <= y + 1; j += 2)
+                alpha = max(alpha, score);
+                if (alpha >= beta)
                 {
-                    if (i < 0 || i > 7 || j < 0 || j > 7 || mtx[i][j])
-                        continue;
-                    turns.emplace_back(x, y, i, j);
+                    telemetry_add<TM_CUTOFFS>(st.counters.cutoffs);
+                    break;
                 }
-                break;
             }
-        default:
-            // check queens
-            for (POS_T i = -1; i <= 1; i += 2)
+        }
+        return best_score;
+    }
+
+    // Оценка полного хода стороны color в окне (alpha, beta):
+    // соперник отвечает на глубине depth, его оценка берётся с обратным знаком.
+    double search_turn(search_state& st, Position& pos, const bool color, const size_t depth, const full_turn& turn,
+                       const double alpha, const double beta)
+    {
+        const turn_undo undo = pos.make_turn(turn);
+        const double score = -find_best_turns_rec(st, pos, 1 - color, depth, -beta, -alpha);
+        pos.unmake_turn(turn, undo);
+        return score;
+    }
+
+    // Упорядочивание ходов перед перебором, чтобы отсечения срабатывали раньше:
+    // 0. Ход главной линии прошлой итерации, если узел лежит на ней.
+    // 1. Лучший ход из таблицы транспозиций.
+    // 2. Удары, сначала берущие больше (дамка за четыре шашки).
+    // 3. Killer-ходы этой глубины.
+    // 4. Остальные тихие ходы по весу в таблице истории.
+    // Сортировка устойчивая, при равных весах сохраняется порядок генератора.
+    // Ход из таблицы задан начальной и конечной клеткой (tt_from, tt_to), -1 — хода нет.
+    void order_turns(const search_state& st, const Position& pos, move_list& turns, const size_t depth,
+                     const int tt_from, const int tt_to) const
+    {
+        if (!move_ordering)
+        {
+            auto it = find_if(turns.begin(), turns.end(),
+                              [&](const full_turn& turn) { return turn.from == tt_from && turn.to() == tt_to; });
+            if (it != turns.end())
+                rotate(turns.begin(), it, it + 1);
+            return;
+        }
+        // Ход корня — индекс 0 главной линии, ход узла глубины depth — индекс depth + 1
+        const size_t pv_index = depth + 1;
+        const bool on_pv = pv_index < size_t(st.prev_pv_length) && st.prev_pv_hash[pv_index] == pos.hash;
+        int weights[MAX_TURNS];
+        for (int i = 0; i < turns.size(); ++i)
+        {
+            const full_turn& turn = turns[i];
+            if (on_pv && turn == st.prev_pv[pv_index])
+                weights[i] = (1 << 30) + 1;
+            else if (turn.from == tt_from && turn.to() == tt_to)
+                weights[i] = 1 << 30;
+            else if (turn.is_beat())
+                weights[i] = (1 << 29) + bit_count(turn.beaten_mask) + 3 * bit_count(turn.beaten_mask & pos.kings);
+            else if (depth < MAX_PLY && turn == st.killers[depth][0])
+                weights[i] = (1 << 28) + 1;
+            else if (depth < MAX_PLY && turn == st.killers[depth][1])
+                weights[i] = 1 << 28;
+            else
+                weights[i] = st.history[turn.from][turn.to()];
+        }
+        // Сортировка вставками: списки короткие
+        for (int i = 1; i < turns.size(); ++i)
+        {
+            const full_turn turn = turns[i];
+            const int weight = weights[i];
+            int j = i - 1;
+            for (; j >= 0 && weights[j] < weight; --j)
             {
-                for (POS_T j = -1; j <= 1; j += 2)
-                {
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                            break;
-                        turns.emplace_back(x, y, i2, j2);
-                    }
-                }
+                turns[j + 1] = turns[j];
+                weights[j + 1] = weights[j];
             }
-            break;
+            turns[j + 1] = turn;
+            weights[j + 1] = weight;
         }
     }
 
+    // Главная линия узла глубины depth: ход turn и линия ответа на него
+    static void update_pv(search_state& st, const size_t depth, const full_turn& turn)
+    {
+        if (depth >= MAX_PLY)
+            return;
+        st.pv[depth][0] = turn;
+        int length = 0;
+        if (depth + 1 < MAX_PLY)
+        {
+            length = min(st.pv_length[depth + 1], MAX_PLY - 1);
+            copy(st.pv[depth + 1], st.pv[depth + 1] + length, st.pv[depth] + 1);
+        }
+        st.pv_length[depth] = length + 1;
+    }
+
+    // Учёт тихого хода, давшего отсечение: killer-ход глубины и вес в таблице истории
+    static void add_killer(search_state& st, const full_turn& turn, const size_t depth, const int rest_depth)
+    {
+        if (depth < MAX_PLY && turn != st.killers[depth][0])
+        {
+            st.killers[depth][1] = st.killers[depth][0];
+            st.killers[depth][0] = turn;
+        }
+        int& weight = st.history[turn.from][turn.to()];
+        weight = min(weight + rest_depth * rest_depth, 1 << 27);
+    }
+
+    // Проверка лимита времени раз в 1024 узла. Первая итерация (глубина 0)
+    // не прерывается, чтобы у бота всегда был ход.
+    bool is_time_up(search_state& st)
+    {
+        ++st.nodes;
+        if (time_limit_ms && st.depth && (st.nodes & 1023) == 0 && chrono::steady_clock::now() >= st.deadline)
+            st.stopped->store(true, memory_order_relaxed);
+        return st.stopped->load(memory_order_relaxed);
+    }
+
+    // Оценка позиции из таблиц эндшпиля для ходящей стороны в узле на расстоянии ply полуходов
+    // от корня. Дистанция считается от корня (ply + дистанция из таблицы), как у матов:
+    // выигрыш тем дороже, чем ближе он к корню, проигрыш тем дешевле, чем он ближе.
+    // Иначе быстрый по таблице выигрыш глубоко в дереве оказался бы дороже более близкого.
+    static double tb_score(const uint8_t value, const size_t ply)
+    {
+        if (value == TB_DRAW)
+            return 0;
+        if (value < TB_LOSS)
+            return INF - double(ply + value);
+        return -(INF - double(ply + value - TB_LOSS));
+    }
+
+    static bool is_tb_score(const double score)
+    {
+        return abs(score) < INF && abs(score) > INF - TB_SCORE_RANGE;
+    }
+
+    // Оценки из таблиц эндшпиля зависят от расстояния до корня, поэтому в таблице
+    // транспозиций они хранятся относительно узла (на расстоянии ply от корня):
+    // при записи расстояние узла убирается, при чтении добавляется расстояние нового узла.
+    static double score_to_tt(const double score, const size_t ply)
+    {
+        if (!is_tb_score(score))
+            return score;
+        return score > 0 ? score + double(ply) : score - double(ply);
+    }
+
+    static double score_from_tt(const double score, const size_t ply)
+    {
+        if (!is_tb_score(score))
+            return score;
+        return score > 0 ? score - double(ply) : score + double(ply);
+    }
+
+    // Ключ позиции для таблицы транспозиций: учитывает очередь хода,
+    // оценки хранятся с точки зрения ходящей стороны.
+    static uint64_t tt_key(const Position& pos, const bool color)
+    {
+        return color ? pos.hash ^ ZOBRIST_BLACK_TURN : pos.hash;
+    }
+
+    // Оценивает позицию для стороны color, см. Evaluator:
+    // материал (шашка — 1, дамка — 4 по умолчанию), а при NumberAndPotential ещё
+    // продвижение шашек, таблицы клеток, охрана первой строки, центр, подвижность и очередь хода.
+    // Если у одной из сторон нет фигур — это проигрыш (-INF) или победа (INF).
+    // Без позиционных слагаемых оценка симметрична: для соперника в той же позиции
+    // она с обратным знаком, равная позиция оценивается нулём.
+    double calc_score(const Position& pos, const bool color) const
+    {
+        return evaluator.score(pos, color, INF);
+    }
+
+public:
+    // Находит все возможные полные ходы для заданного цвета. 
+    // color Цвет игрока (0 или 1), для которого нужно найти ходы. 
+    // Обёртка для Game: найденные ходы копируются в turns и have_beats. 
+    // Сохраняются все серии ударов, даже ведущие к одной позиции,
+    // чтобы игрок мог бить в любом допустимом порядке.
+
+    void find_turns(const bool color, const Position& pos)
+    {
+        move_list list;
+        Rules::find_turns(color, pos, list, false);
+        turns.assign(list.begin(), list.end());
+        have_beats = list.have_beats;
+    }
+
+    // Ходы всего цвета в список вызывающего, см. Rules::find_turns
+    void find_turns(const bool color, const Position& pos, move_list& list) const
+    {
+        Rules::find_turns(color, pos, list);
+    }
+
+    // Ходы одной шашки в список вызывающего, см. Rules::find_turns
+    void find_turns(const POS_T x, const POS_T y, const Position& pos, move_list& list) const
+    {
+        Rules::find_turns(x, y, pos, list);
+    }
+
   public:
-      // Список всех возможных ходов, найденных последним вызовом find_turns(). 
-      // Заполняется как для одной шашки, так и для всего цвета.
-      vector<move_pos> turns;
+      // Список всех возможных полных ходов, найденных последним вызовом find_turns(color). 
+      // Поиск бота его не использует.
+      vector<full_turn> turns;
 
       // Флаг, показывающий, есть ли среди найденных ходов хотя бы один удар. 
       // Если true — обычные ходы игнорируются.
@@ -366,19 +776,66 @@ private:
       // Определяет «силу» бота: чем больше глубина, тем сильнее игра.
       int Max_depth;
 
+      // Таблица транспозиций, общая для всех поисков и потоков этой партии. 
+      Transposition_table tt;
+
+      // Таблицы эндшпиля (TablebasePath, TablebasePieces), отображённые в память.
+      Tablebase tablebase;
+
+      // Оценка позиции: режим BotScoringType, веса из EvalWeightsPath.
+      Evaluator evaluator;
+
+      // Дебютная книга (BookPath), отображённая в память.
+      Opening_book book;
+
+      // Последний ход взят из дебютной книги, без поиска.
+      bool from_book = false;
+
+      // Последний ход взят из пондеринга: человек сыграл предсказанный ход.
+      bool from_ponder = false;
+
+      // Вызывается из фонового потока, когда пондеринг закончился сам (Game будит им ожидание ввода).
+      function<void()> on_ponder_done;
+
+      // Главная линия последнего поиска: ход бота и ожидаемые ответы.
+      // Пишется в log.txt после каждого хода бота.
+      vector<full_turn> pv;
+
+      // Количество узлов, посещённых последним поиском (сумма по потокам).
+      size_t nodes = 0;
+
+      // Оценка лучшего хода последнего поиска для ходящей стороны (0 для хода из книги).
+      double score = 0;
+
+      // Упорядочивание ходов (killer-ходы, история отсечений). 
+      // Выключается только для сравнения числа узлов в Tools/headless.cpp.
+      bool move_ordering = true;
+
+      // Счётчики попаданий/промахов/коллизий таблицы за последний поиск, пишутся в log.txt.
+      tt_stats stats;
+
+      // Телеметрия последнего хода: узлы, счётчики, глубина, линия, время (см. Telemetry.h).
+      search_record telemetry;
+
   private:
-      // Режим оптимизации поиска. // Например: "O0", "O1", "O2" — влияет на включение alpha-beta отсечение.
-      string optimization;
-      // Массив, где для каждого состояния Minimax хранится выбранный ход. 
-      // Используется для восстановления цепочки ходов (например, серии ударов).
-      vector<move_pos> next_move;
-      // Массив, где для каждого состояния хранится индекс следующего состояния. 
-      // Позволяет восстановить последовательность ходов, ведущую к лучшему результату.
-      vector<int> next_best_state;
-      // Указатель на объект доски. 
-      // Используется для получения текущего состояния игрового поля.
-      Board* board;
+      // Режим оптимизации поиска: O0, O1, O2 — влияет на включение alpha-beta отсечения и PVS.
+      Optimization optimization = Optimization::O2;
+      // Лимит времени на ход в миллисекундах, 0 — без лимита.
+      int time_limit_ms = 0;
+      // Детерминированный поиск: результат не зависит от числа потоков и их скорости.
+      bool no_random = false;
+      // Количество потоков поиска.
+      int threads = 1;
+      // Выбор хода книги случайно по весам (BookSelection = "Weighted").
+      bool book_weighted = false;
+      // Генератор случайных чисел для выбора хода книги.
+      mt19937 rand_eng{random_device{}()};
+      // Пондеринг во время хода человека (Ponder).
+      bool ponder_enabled = false;
       // Указатель на объект конфигурации. 
       // Содержит настройки бота: глубина поиска, режим оценки, рандомизация и т.д.
-      Config* config;
+      const Config* config;
+      // Идущий пондеринг. Объявлен последним, чтобы при разрушении Logic поток
+      // остановился раньше, чем будут разрушены данные, которые он читает.
+      unique_ptr<ponder_task> ponder;
 };
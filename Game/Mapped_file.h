@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Файл, отображённый в память только для чтения
+class Mapped_file
+{
+  public:
+    Mapped_file() = default;
+
+    Mapped_file(const Mapped_file&) = delete;
+    Mapped_file& operator=(const Mapped_file&) = delete;
+
+    Mapped_file(Mapped_file&& other) noexcept
+    {
+        *this = move(other);
+    }
+
+    Mapped_file& operator=(Mapped_file&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            swap(data_, other.data_);
+            swap(size_, other.size_);
+#ifdef _WIN32
+            swap(mapping, other.mapping);
+#endif
+        }
+        return *this;
+    }
+
+    ~Mapped_file()
+    {
+        close();
+    }
+
+    // Отображает файл целиком, false — файла нет или он пуст
+    bool open(const string& path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!data_)
+        {
+            CloseHandle(mapping);
+            mapping = NULL;
+            return false;
+        }
+        size_ = size_t(file_size.QuadPart);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void* ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (ptr == MAP_FAILED)
+            return false;
+        data_ = static_cast<const uint8_t*>(ptr);
+        size_ = size_t(st.st_size);
+#endif
+        return true;
+    }
+
+    void close()
+    {
+        if (!data_)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping);
+        mapping = NULL;
+#else
+        munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t* data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE mapping = NULL;
+#endif
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Models/Move_list.h"
+#include "../Models/Position.h"
+#include "Mapped_file.h"
+
+using namespace std;
+
+// Ход книги: ключ позиции (с учётом стороны, которая ходит), ход и его вес.
+// Ход задаётся клеткой начала, клеткой конца и битыми фигурами —
+// так однозначно определяется любая серия ударов.
+struct book_entry
+{
+    uint64_t key = 0;
+    uint32_t beaten_mask = 0;
+    int8_t from = -1;
+    int8_t to = -1;
+    uint16_t weight = 0;  // чем больше, тем чаще выбирается ход
+};
+
+// Заголовок файла книги, за ним идут count записей book_entry, отсортированных по ключу
+struct book_header
+{
+    char magic[4] = {'C', 'K', 'B', 'K'};
+    uint8_t version = 1;
+    uint8_t plies = 0;  // глубина книги в полуходах от начальной позиции
+    uint8_t level = 0;  // уровень поиска, которым оценивались ходы
+    uint8_t reserved[5] = {};
+    uint32_t count = 0;
+};
+
+// Дебютная книга: заранее посчитанные ходы для первых позиций партии.
+// Строится Tools/bookgen.cpp, здесь файл только отображается в память,
+// а позиция ищется двоичным поиском по ключу.
+class Opening_book
+{
+  public:
+    // Отображает файл книги, false — файла нет или он повреждён
+    bool load(const string& path)
+    {
+        close();
+        if (!file.open(path) || file.size() < sizeof(book_header))
+            return false;
+        book_header header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, book_header().magic, 4) != 0 || header.version != book_header().version ||
+            file.size() != sizeof(book_header) + size_t(header.count) * sizeof(book_entry))
+        {
+            close();
+            return false;
+        }
+        entries = reinterpret_cast<const book_entry*>(file.data() + sizeof(book_header));
+        count = header.count;
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        entries = nullptr;
+        count = 0;
+    }
+
+    // Количество ходов в книге
+    size_t size() const
+    {
+        return count;
+    }
+
+    // Ходы книги для позиции с ходом color, сопоставленные с допустимыми ходами turns.
+    // В moves — ходы, в weights — их веса; false — позиции в книге нет.
+    bool probe(const Position& pos, const bool color, const move_list& turns, vector<full_turn>& moves,
+               vector<int>& weights) const
+    {
+        moves.clear();
+        weights.clear();
+        const uint64_t k = key(pos, color);
+        const book_entry* it = lower_bound(entries, entries + count, k,
+                                           [](const book_entry& e, const uint64_t k) { return e.key < k; });
+        for (; it != entries + count && it->key == k; ++it)
+        {
+            for (const auto& turn : turns)
+            {
+                if (turn.from == it->from && turn.to() == it->to && turn.beaten_mask == it->beaten_mask)
+                {
+                    moves.push_back(turn);
+                    weights.push_back(it->weight);
+                    break;
+                }
+            }
+        }
+        return !moves.empty();
+    }
+
+    // Ключ позиции в книге, совпадает с ключом таблицы транспозиций
+    static uint64_t key(const Position& pos, const bool color)
+    {
+        return color ? pos.hash ^ ZOBRIST_BLACK_TURN : pos.hash;
+    }
+
+    static book_entry make_entry(const Position& pos, const bool color, const full_turn& turn, const int weight)
+    {
+        book_entry entry;
+        entry.key = key(pos, color);
+        entry.beaten_mask = turn.beaten_mask;
+        entry.from = turn.from;
+        entry.to = turn.to();
+        entry.weight = uint16_t(max(1, min(weight, 65535)));
+        return entry;
+    }
+
+    // Сортирует записи по ключу (внутри позиции — по убыванию веса) и пишет файл книги.
+    // Пишется во временный файл, который затем переименовывается.
+    static void write(const string& path, vector<book_entry> entries, book_header header)
+    {
+        sort(entries.begin(), entries.end(), [](const book_entry& a, const book_entry& b) {
+            return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+        });
+        header.count = uint32_t(entries.size());
+        {
+            ofstream fout(path + ".tmp", ios::binary | ios::trunc);
+            fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            fout.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(book_entry));
+            if (!fout)
+                throw runtime_error("can't write " + path + ".tmp");
+        }
+        remove(path.c_str());
+        if (rename((path + ".tmp").c_str(), path.c_str()) != 0)
+            throw runtime_error("can't rename " + path + ".tmp");
+    }
+
+  private:
+    Mapped_file file;
+    const book_entry* entries = nullptr;
+    size_t count = 0;
+};
@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+#include "../Models/Move.h"
+#include "../Models/Move_list.h"
+#include "../Models/Position.h"
+
+// Правила игры: генерация ходов по позиции.
+// Не зависит от SDL, Board и Config, поэтому используется и в Logic, и в State,
+// и в консольных инструментах.
+class Rules
+{
+  public:
+    // Находит все возможные полные ходы для всех шашек указанного цвета.
+    // Алгоритм: 
+    // 1. Обходит фигуры нужного цвета по маске (в порядке номеров клеток, т.е. построчно). 
+    // 2. Сначала собирает серии ударов всех фигур, каждая серия — один полный ход. 
+    // 3. Если хотя бы одна шашка может бить — сохраняются только бьющие ходы. 
+    // 4. Если бить нельзя — сохраняются обычные ходы.
+    // При unique серии, приводящие к одной и той же позиции, сохраняются один раз (первая из них).
+    // Результат: список ходов в list, который принадлежит вызывающему. 
+    // Функция не имеет состояния и может вызываться из нескольких потоков.
+
+    static void find_turns(const bool color, const Position& pos, move_list& list, const bool unique = true)
+    {
+        list.clear();
+        for (uint32_t own = pos.pieces(color); own;)
+            add_beats(pop_lowest_bit(own), pos, list, unique);
+        list.have_beats = !list.empty();
+        if (list.have_beats)
+            return;
+        for (uint32_t own = pos.pieces(color); own;)
+            add_moves(pop_lowest_bit(own), pos, list);
+    }
+
+    // Находит все возможные полные ходы для одной конкретной шашки
+    // Алгоритм: 
+    // 1. Сначала ищет ВСЕ возможные серии ударов: 
+    // - Для обычных шашек: проверяет клетки через одну. 
+    // - Для дамок: ищет удар на любой дистанции по диагонали. 
+    // - Серия продолжается, пока есть удар; побитые фигуры снимаются сразу, 
+    //   шашка, дошедшая до последней строки посреди серии, бьёт дальше как дамка. 
+    // 2. Если удары найдены — обычные ходы НЕ рассматриваются. 
+    // 3. Если ударов нет — ищет обычные ходы: 
+    // - Для обычных шашек: один шаг вперёд по диагонали. 
+    // - Для дамок: любое количество клеток по диагонали.
+    // Результат: 
+    // - list — список всех ходов этой шашки. 
+    // - list.have_beats — true, если найден хотя бы один удар.
+
+    static void find_turns(const POS_T x, const POS_T y, const Position& pos, move_list& list,
+                           const bool unique = true)
+    {
+        list.clear();
+        const int s = Position::sq(x, y);
+        add_beats(s, pos, list, unique);
+        list.have_beats = !list.empty();
+        if (!list.have_beats)
+            add_moves(s, pos, list);
+    }
+
+  private:
+    // Наибольшее число отдельных ударов одной фигуры: 4 направления, до 6 клеток за побитой
+    static const int MAX_HOPS = 32;
+
+    // Добавляет в list все серии ударов фигуры с клетки s
+    static void add_beats(const int s, const Position& pos, move_list& list, const bool unique)
+    {
+        full_turn turn;
+        turn.from = int8_t(s);
+        add_series(s, pos, turn, list, list.size(), unique);
+    }
+
+    // Продолжает серию turn фигурой, стоящей на клетке s. Серия без продолжения попадает в list,
+    // если среди ходов этой фигуры (начиная с first) нет хода с той же итоговой позицией.
+    static void add_series(const int s, const Position& pos, full_turn& turn, move_list& list, const int first,
+                           const bool unique)
+    {
+        int8_t to[MAX_HOPS], beaten[MAX_HOPS];
+        const int n = find_hops(s, pos, to, beaten);
+        if (!n)
+        {
+            if (!turn.count)
+                return;
+            if (unique && find(list.begin() + first, list.end(), turn) != list.end())
+                return;
+            list.push_back(turn);
+            return;
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            // Удар на копии позиции: шашка переносится, побитая снимается сразу
+            Position next = pos;
+            const uint32_t from = Position::bit(s), dest = Position::bit(to[i]), b = Position::bit(beaten[i]);
+            const bool is_white = (next.white & from) != 0;
+            (is_white ? next.white : next.black) ^= from | dest;
+            (is_white ? next.black : next.white) &= ~b;
+            next.kings &= ~b;
+            const bool promotion = turn.promotion;
+            if (next.kings & from)
+                next.kings ^= from | dest;
+            else if (dest & (is_white ? WHITE_PROMOTION_ROW_MASK : BLACK_PROMOTION_ROW_MASK))
+            {
+                next.kings |= dest;
+                turn.promotion = true;
+            }
+            turn.path[turn.count] = to[i];
+            turn.beaten[turn.count] = beaten[i];
+            ++turn.count;
+            turn.beaten_mask |= b;
+            add_series(to[i], next, turn, list, first, unique);
+            turn.beaten_mask &= ~b;
+            --turn.count;
+            turn.promotion = promotion;
+        }
+    }
+
+    // Отдельные удары фигуры с клетки s: клетки приземления в to, побитые клетки в beaten.
+    // Возвращает число ударов.
+    static int find_hops(const int s, const Position& pos, int8_t* to, int8_t* beaten)
+    {
+        int n = 0;
+        const uint32_t b = Position::bit(s);
+        const uint32_t enemy = (pos.white & b) ? pos.black : pos.white;
+        const uint32_t occupied = pos.occupied();
+        if (!(pos.kings & b))
+        {
+            // check pieces
+            for (int d = 0; d < 4; ++d)
+            {
+                const int sb = SQUARE_STEPS[s][d];
+                if (sb == -1 || !(enemy & Position::bit(sb)))
+                    continue;
+                const int s2 = SQUARE_STEPS[sb][d];
+                if (s2 == -1 || (occupied & Position::bit(s2)))
+                    continue;
+                to[n] = int8_t(s2);
+                beaten[n++] = int8_t(sb);
+            }
+            return n;
+        }
+        // check queens
+        for (int d = 0; d < 4; ++d)
+        {
+            int sb = -1;
+            for (int s2 = SQUARE_STEPS[s][d]; s2 != -1; s2 = SQUARE_STEPS[s2][d])
+            {
+                if (occupied & Position::bit(s2))
+                {
+                    if (sb != -1 || !(enemy & Position::bit(s2)))
+                        break;
+                    sb = s2;
+                }
+                else if (sb != -1)
+                {
+                    to[n] = int8_t(s2);
+                    beaten[n++] = int8_t(sb);
+                }
+            }
+        }
+        return n;
+    }
+
+    // Добавляет в list тихие ходы фигуры с клетки s
+    static void add_moves(const int s, const Position& pos, move_list& list)
+    {
+        const uint32_t b = Position::bit(s);
+        const uint32_t occupied = pos.occupied();
+        if (!(pos.kings & b))
+        {
+            // check pieces: белые ходят вверх (направления 0, 1), чёрные вниз (2, 3)
+            const bool is_white = (pos.white & b) != 0;
+            const int d0 = is_white ? 0 : 2;
+            const uint32_t promotion_row = is_white ? WHITE_PROMOTION_ROW_MASK : BLACK_PROMOTION_ROW_MASK;
+            for (int d = d0; d < d0 + 2; ++d)
+            {
+                const int s2 = SQUARE_STEPS[s][d];
+                if (s2 != -1 && !(occupied & Position::bit(s2)))
+                    add_turn(list, s, s2, (promotion_row & Position::bit(s2)) != 0);
+            }
+            return;
+        }
+        // check queens
+        for (int d = 0; d < 4; ++d)
+        {
+            for (int s2 = SQUARE_STEPS[s][d]; s2 != -1 && !(occupied & Position::bit(s2)); s2 = SQUARE_STEPS[s2][d])
+                add_turn(list, s, s2, false);
+        }
+    }
+
+    static void add_turn(move_list& list, const int s, const int s2, const bool promotion)
+    {
+        full_turn turn;
+        turn.from = int8_t(s);
+        turn.count = 1;
+        turn.path[0] = int8_t(s2);
+        turn.beaten[0] = -1;
+        turn.promotion = promotion;
+        list.push_back(turn);
+    }
+};
@@ -0,0 +1,251 @@
+#pragma once
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Position.h"
+
+using namespace std;
+
+// Шаг партии в истории: ход на одну клетку (тихий ход или один удар серии) и то,
+// что нельзя восстановить по позиции после него, — была ли побитая фигура дамкой
+// и превратилась ли шашка. 9 байт вместо копии позиции.
+struct history_entry
+{
+    move_pos turn;
+    bool beaten_king = false;
+    bool promoted = false;
+    int8_t beat_series = 0; // номер удара в серии, 0 — тихий ход
+};
+
+// Состояние партии без отрисовки: текущая позиция и история ходов.
+// Не зависит от SDL, Board только показывает это состояние.
+// История хранится как стартовая позиция и последовательность шагов; откат и повтор
+// выполняются через unmake_turn/make_turn, любая позиция партии восстанавливается по запросу.
+// Ключи Zobrist всех позиций партии хранятся отдельно для поиска повторений.
+class State
+{
+  public:
+    State()
+    {
+        reset();
+    }
+
+    // Полный сброс партии: стартовая расстановка и пустая история
+    void reset()
+    {
+        start_history(Position::make_start());
+    }
+
+    // Перемещение шашки с возможным удалением побитой
+    void move_piece(const move_pos turn, const int beat_series = 0)
+    {
+        // Проверка корректности хода
+        if (pos.type(Position::sq(turn.x2, turn.y2)))
+        {
+            throw runtime_error("final position is not empty, can't move");
+        }
+        if (!pos.type(Position::sq(turn.x, turn.y)))
+        {
+            throw runtime_error("begin position is empty, can't move");
+        }
+        // Новый ход отменяет отложенные повторы
+        redo_entries.clear();
+        apply(history_entry{ turn, false, false, int8_t(beat_series) });
+    }
+
+    // Перемещение шашки без удара
+    void move_piece(const POS_T i, const POS_T j, const POS_T i2, const POS_T j2, const int beat_series = 0)
+    {
+        move_piece(move_pos(i, j, i2, j2), beat_series);
+    }
+
+    // Удаление шашки с клетки.
+    // Правка позиции не является ходом, поэтому история начинается заново с исправленной позиции.
+    void drop_piece(const POS_T i, const POS_T j)
+    {
+        const uint32_t b = ~Position::bit(Position::sq(i, j));
+        Position edited = pos;
+        edited.white &= b;
+        edited.black &= b;
+        edited.kings &= b;
+        edited.recalc();
+        start_history(edited);
+    }
+
+    // Превращение шашки в дамку вручную (тоже начинает историю заново)
+    void turn_into_queen(const POS_T i, const POS_T j)
+    {
+        const POS_T type = pos.type(Position::sq(i, j));
+        if (type == 0 || type > 2)
+        {
+            throw runtime_error("can't turn into queen in this position");
+        }
+        Position edited = pos;
+        edited.kings |= Position::bit(Position::sq(i, j));
+        edited.recalc();
+        start_history(edited);
+    }
+
+    // Откат хода с учётом серии ударов. Откаченные шаги можно вернуть через redo().
+    void rollback()
+    {
+        if (entries.empty())
+            return;
+        auto beat_series = max(1, int(entries.back().beat_series));
+
+        // Откатываем все шаги, относящиеся к серии ударов
+        while (beat_series-- && !entries.empty())
+        {
+            redo_entries.push_back(entries.back());
+            unmake_last();
+        }
+    }
+
+    // Повтор последнего откаченного хода (всей серии ударов).
+    // Возвращает false, если повторять нечего.
+    bool redo()
+    {
+        if (redo_entries.empty())
+            return false;
+        do
+        {
+            apply(redo_entries.back());
+            redo_entries.pop_back();
+        } while (!redo_entries.empty() && redo_entries.back().beat_series > 1);
+        return true;
+    }
+
+    // Тип фигуры на клетке: 0 - пусто, 1 - белая, 2 - чёрная, 3 - белая дамка, 4 - чёрная дамка
+    POS_T at(const POS_T i, const POS_T j) const
+    {
+        return ((i + j) % 2) ? pos.type(Position::sq(i, j)) : POS_T(0);
+    }
+
+    vector<vector<POS_T>> get_board() const
+    {
+        return pos.to_mtx();
+    }
+
+    const Position& position() const
+    {
+        return pos;
+    }
+
+    // Количество сохранённых состояний (вместе со стартовым)
+    size_t history_size() const
+    {
+        return entries.size() + 1;
+    }
+
+    // Шаги партии по порядку
+    const vector<history_entry>& history() const
+    {
+        return entries;
+    }
+
+    // Позиция после первых ply шагов (0 — стартовая). Восстанавливается от ближайшего
+    // конца истории: ходами от стартовой позиции или откатами от текущей.
+    Position position_at(const size_t ply) const
+    {
+        if (ply >= history_size())
+            throw runtime_error("no such ply in the history");
+        Position res;
+        if (ply <= entries.size() / 2)
+        {
+            res = start;
+            for (size_t i = 0; i < ply; ++i)
+                res.make_turn(entries[i].turn);
+        }
+        else
+        {
+            res = pos;
+            for (size_t i = entries.size(); i > ply; --i)
+                res.unmake_turn(entries[i - 1].turn, make_undo(res, entries[i - 1], hashes[i - 1]));
+        }
+        return res;
+    }
+
+    // Сколько раз текущая позиция с той же очередью хода уже встречалась в партии.
+    // Взятие и превращение необратимы, поэтому позиции до них не сравниваются: между
+    // сравниваемыми позициями только тихие ходы по одному шагу, и очередь хода
+    // совпадает через чётное число шагов. Ключи сравниваются сразу, позиции — при совпадении ключей.
+    int repetitions() const
+    {
+        const size_t n = entries.size();
+        int res = 0;
+        for (size_t ply = n; ply >= 2 && reversible(entries[ply - 1]) && reversible(entries[ply - 2]); ply -= 2)
+        {
+            if (hashes[ply - 2] == hashes[n] && position_at(ply - 2) == pos)
+                ++res;
+        }
+        return res;
+    }
+
+  private:
+    // Начинает историю заново с позиции from
+    void start_history(const Position& from)
+    {
+        start = from;
+        pos = from;
+        entries.clear();
+        redo_entries.clear();
+        hashes.assign(1, pos.hash);
+    }
+
+    // Выполняет шаг и записывает его в историю
+    void apply(history_entry entry)
+    {
+        const turn_undo undo = pos.make_turn(entry.turn);
+        entry.beaten_king = undo.beaten_king;
+        entry.promoted = undo.promoted;
+        entries.push_back(entry);
+        hashes.push_back(pos.hash);
+    }
+
+    // Откатывает последний шаг истории
+    void unmake_last()
+    {
+        pos.unmake_turn(entries.back().turn, make_undo(pos, entries.back(), hashes[entries.size() - 1]));
+        entries.pop_back();
+        hashes.pop_back();
+    }
+
+    // Данные для отката шага из позиции after после него: ключ берётся из истории,
+    // счётчики оценки возвращаются обратными add/remove, без пересчёта доски
+    static turn_undo make_undo(const Position& after, const history_entry& entry, const uint64_t hash_before)
+    {
+        turn_undo undo;
+        undo.hash = hash_before;
+        undo.beaten_king = entry.beaten_king;
+        undo.promoted = entry.promoted;
+        undo.counters = after.counters;
+        const move_pos& turn = entry.turn;
+        const int s_from = Position::sq(turn.x, turn.y), s_to = Position::sq(turn.x2, turn.y2);
+        const POS_T type_to = after.type(s_to);
+        undo.counters.remove(type_to, s_to);
+        undo.counters.add(entry.promoted ? type_to - 2 : type_to, s_from);
+        if (turn.xb != -1)
+        {
+            // Побитая фигура — цвета соперника: белым (нечётный тип) соответствует чёрная
+            const int type_beaten = (type_to % 2 ? 2 : 1) + (entry.beaten_king ? 2 : 0);
+            undo.counters.add(type_beaten, Position::sq(turn.xb, turn.yb));
+        }
+        return undo;
+    }
+
+    static bool reversible(const history_entry& entry)
+    {
+        return entry.turn.xb == -1 && !entry.promoted;
+    }
+
+    // Стартовая позиция истории и текущая позиция
+    Position start;
+    Position pos;
+    // Шаги партии и откаченные шаги для redo (последний откаченный — в конце)
+    vector<history_entry> entries;
+    vector<history_entry> redo_entries;
+    // Ключи Zobrist позиций: hashes[i] — после i шагов
+    vector<uint64_t> hashes;
+};
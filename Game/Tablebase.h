@@ -0,0 +1,257 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Models/Position.h"
+#include "Mapped_file.h"
+
+using namespace std;
+
+// Значение позиции в таблице эндшпиля (для стороны, которая ходит):
+// 0 — ничья, 1..127 — выигрыш за столько полуходов,
+// 128 + d — проигрыш через d полуходов (128 — ходов нет уже сейчас), 255 — позиция невозможна.
+const uint8_t TB_DRAW = 0;
+const uint8_t TB_LOSS = 128;
+const uint8_t TB_INVALID = 255;
+// Наибольшая дистанция, которую можно записать
+const int TB_MAX_DIST = 126;
+
+// Биномиальные коэффициенты C(n, k) для номеров наборов клеток
+constexpr array<array<uint64_t, 33>, 33> make_binomials()
+{
+    array<array<uint64_t, 33>, 33> res{};
+    for (int n = 0; n <= 32; ++n)
+    {
+        res[n][0] = 1;
+        for (int k = 1; k <= n; ++k)
+            res[n][k] = res[n - 1][k - 1] + (k < n ? res[n - 1][k] : 0);
+    }
+    return res;
+}
+
+constexpr array<array<uint64_t, 33>, 33> BINOMIALS = make_binomials();
+
+// Заголовок файла таблицы, за ним идут size() байт значений
+struct tb_header
+{
+    char magic[4] = {'C', 'K', 'T', 'B'};
+    uint8_t version = 1;
+    uint8_t counts[4] = {};  // шашки и дамки ходящей стороны, шашки и дамки соперника
+    uint8_t max_dist = 0;    // наибольшая дистанция в таблице
+    uint8_t reserved[6] = {};
+};
+
+// Таблицы эндшпиля: точный результат и дистанция до него для всех позиций
+// с небольшим числом фигур. Строятся Tools/tbgen.cpp, здесь только отображаются в память.
+// На каждый набор фигур (шашки и дамки ходящей стороны, шашки и дамки соперника) — свой файл.
+// Позиции хранятся только с ходом белых: позиция с ходом чёрных поворачивается на 180 градусов
+// (клетка s переходит в 31 - s) и цвета меняются местами, правила при этом не меняются.
+class Tablebase
+{
+  public:
+    // Отображает все найденные в dir таблицы не больше чем для max_pieces фигур
+    void load(const string& dir, const int max_pieces)
+    {
+        files.clear();
+        tables.assign(SIGNATURES, nullptr);
+        pieces = 0;
+        for (int code = 0; code < SIGNATURES; ++code)
+        {
+            int counts[4];
+            decode(code, counts);
+            const int total = counts[0] + counts[1] + counts[2] + counts[3];
+            if (total > max_pieces || counts[0] + counts[1] == 0 || counts[2] + counts[3] == 0)
+                continue;
+            Mapped_file file;
+            if (!file.open(dir + file_name(counts)) || file.size() != sizeof(tb_header) + size(counts))
+                continue;
+            tb_header header;
+            memcpy(&header, file.data(), sizeof(header));
+            if (memcmp(header.magic, tb_header().magic, 4) != 0 || header.version != tb_header().version)
+                continue;
+            tables[code] = file.data() + sizeof(tb_header);
+            files.push_back(move(file));
+            pieces = max(pieces, total);
+        }
+    }
+
+    // Наибольшее число фигур среди загруженных таблиц, 0 — таблиц нет
+    // Закрывает все таблицы, после этого probe ничего не находит
+    void close()
+    {
+        files.clear();
+        tables.assign(SIGNATURES, nullptr);
+        pieces = 0;
+    }
+
+    int max_pieces() const
+    {
+        return pieces;
+    }
+
+    // Значение позиции для стороны color, которая сейчас ходит.
+    // false — таблицы для такого набора фигур нет.
+    bool probe(const Position& pos, const bool color, uint8_t& value) const
+    {
+        if (bit_count(pos.occupied()) > pieces)
+            return false;
+        int counts[4];
+        size_t index;
+        if (!locate(pos, color, counts, index))
+            return false;
+        // Ходить нечем — проигрыш, отдельной таблицы для этого нет
+        if (counts[0] + counts[1] == 0)
+        {
+            value = TB_LOSS;
+            return true;
+        }
+        const uint8_t* table = tables[encode(counts)];
+        if (!table)
+            return false;
+        value = table[index];
+        return value != TB_INVALID;
+    }
+
+    // Набор фигур и номер позиции в его таблице. Возвращает false, если в наборе
+    // больше фигур, чем помещается в кодировку (MAX_COUNT каждого вида).
+    static bool locate(const Position& pos, const bool color, int counts[4], size_t& index)
+    {
+        uint32_t groups[4];
+        split(pos, color, groups);
+        for (int i = 0; i < 4; ++i)
+        {
+            counts[i] = bit_count(groups[i]);
+            if (counts[i] > MAX_COUNT)
+                return false;
+        }
+        index = 0;
+        for (int i = 0; i < 4; ++i)
+            index = index * binomial(32, counts[i]) + rank(groups[i]);
+        return true;
+    }
+
+    // Позиция с ходом белых по номеру в таблице набора counts.
+    // false — клетки групп пересекаются или шашка стоит на строке своего превращения.
+    static bool unrank(const int counts[4], size_t index, Position& pos)
+    {
+        uint32_t groups[4];
+        for (int i = 3; i >= 0; --i)
+        {
+            const size_t n = binomial(32, counts[i]);
+            groups[i] = unrank_group(counts[i], index % n);
+            index /= n;
+        }
+        if ((groups[0] & groups[1]) || ((groups[0] | groups[1]) & (groups[2] | groups[3])) || (groups[2] & groups[3]))
+            return false;
+        if ((groups[0] & WHITE_PROMOTION_ROW_MASK) || (groups[2] & BLACK_PROMOTION_ROW_MASK))
+            return false;
+        pos.white = groups[0] | groups[1];
+        pos.black = groups[2] | groups[3];
+        pos.kings = groups[1] | groups[3];
+        pos.recalc();
+        return true;
+    }
+
+    // Число позиций в таблице набора counts (с невозможными)
+    static size_t size(const int counts[4])
+    {
+        size_t res = 1;
+        for (int i = 0; i < 4; ++i)
+            res *= binomial(32, counts[i]);
+        return res;
+    }
+
+    // Имя файла таблицы, например tb_2011.bin — две шашки и дамка против дамки
+    static string file_name(const int counts[4])
+    {
+        string res = "tb_";
+        for (int i = 0; i < 4; ++i)
+            res += char('0' + counts[i]);
+        return res + ".bin";
+    }
+
+    static int encode(const int counts[4])
+    {
+        return ((counts[0] * (MAX_COUNT + 1) + counts[1]) * (MAX_COUNT + 1) + counts[2]) * (MAX_COUNT + 1) +
+               counts[3];
+    }
+
+    static void decode(int code, int counts[4])
+    {
+        for (int i = 3; i >= 0; --i)
+        {
+            counts[i] = code % (MAX_COUNT + 1);
+            code /= MAX_COUNT + 1;
+        }
+    }
+
+    // Наибольшее число фигур одного вида в таблицах
+    static const int MAX_COUNT = 8;
+    static const int SIGNATURES = (MAX_COUNT + 1) * (MAX_COUNT + 1) * (MAX_COUNT + 1) * (MAX_COUNT + 1);
+
+  private:
+    // Группы фигур с точки зрения стороны color: её шашки, её дамки, шашки и дамки соперника.
+    // Для хода чёрных доска поворачивается, чтобы ходящая сторона играла белыми.
+    static void split(const Position& pos, const bool color, uint32_t groups[4])
+    {
+        uint32_t own = pos.pieces(color), other = pos.pieces(!color), kings = pos.kings;
+        if (color)
+        {
+            own = reverse(own);
+            other = reverse(other);
+            kings = reverse(kings);
+        }
+        groups[0] = own & ~kings;
+        groups[1] = own & kings;
+        groups[2] = other & ~kings;
+        groups[3] = other & kings;
+    }
+
+    // Номер набора клеток среди всех наборов того же размера (комбинаторная система счисления)
+    static size_t rank(uint32_t group)
+    {
+        size_t res = 0;
+        for (int i = 1; group; ++i)
+            res += binomial(pop_lowest_bit(group), i);
+        return res;
+    }
+
+    static uint32_t unrank_group(const int count, size_t index)
+    {
+        uint32_t res = 0;
+        for (int i = count; i > 0; --i)
+        {
+            int s = i - 1;
+            while (s + 1 < 32 && binomial(s + 1, i) <= index)
+                ++s;
+            index -= binomial(s, i);
+            res |= Position::bit(s);
+        }
+        return res;
+    }
+
+    // Поворот доски на 180 градусов: бит s переходит в бит 31 - s
+    static uint32_t reverse(uint32_t b)
+    {
+        b = ((b >> 1) & 0x55555555u) | ((b & 0x55555555u) << 1);
+        b = ((b >> 2) & 0x33333333u) | ((b & 0x33333333u) << 2);
+        b = ((b >> 4) & 0x0F0F0F0Fu) | ((b & 0x0F0F0F0Fu) << 4);
+        b = ((b >> 8) & 0x00FF00FFu) | ((b & 0x00FF00FFu) << 8);
+        return (b >> 16) | (b << 16);
+    }
+
+    static size_t binomial(const int n, const int k)
+    {
+        return size_t(BINOMIALS[n][k]);
+    }
+
+    // Отображённые файлы и указатели на значения по коду набора фигур
+    vector<Mapped_file> files;
+    vector<const uint8_t*> tables;
+    int pieces = 0;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../Models/Position.h"
+#include "Transposition_table.h"
+
+using namespace std;
+
+// Счётчики поиска для телеметрии. Набор включённых счётчиков задаётся при сборке:
+// -DTELEMETRY_COUNTERS="TM_EVALS|TM_CUTOFFS" или -DTELEMETRY_COUNTERS=0.
+// Выключенный счётчик не компилируется в поиск и не пишется в лог.
+// Узлы, глубина, таблица транспозиций, главная линия и время есть всегда:
+// они считаются поиском и без телеметрии.
+const unsigned TM_EVALS = 1;         // оценки листьев (calc_score)
+const unsigned TM_CUTOFFS = 2;       // отсечения по beta
+const unsigned TM_FIRST_CUTOFFS = 4; // отсечения на первом ходе узла (качество упорядочивания)
+const unsigned TM_QNODES = 8;        // узлы поиска ударов (quiescence)
+const unsigned TM_TB_HITS = 16;      // позиции, найденные в таблицах эндшпиля
+const unsigned TM_ALL = 31;
+
+#ifndef TELEMETRY_COUNTERS
+#define TELEMETRY_COUNTERS TM_ALL
+#endif
+
+constexpr unsigned TELEMETRY = TELEMETRY_COUNTERS;
+
+// Увеличивает счётчик, если он включён при сборке, иначе ничего не делает
+template <unsigned counter> inline void telemetry_add(size_t& value)
+{
+    if constexpr ((TELEMETRY & counter) != 0)
+        ++value;
+}
+
+// Счётчики одного потока поиска, после поиска суммируются по потокам
+struct search_counters
+{
+    size_t evals = 0;
+    size_t cutoffs = 0;
+    size_t first_cutoffs = 0;
+    size_t qnodes = 0;
+    size_t tb_hits = 0;
+
+    search_counters& operator+=(const search_counters& other)
+    {
+        evals += other.evals;
+        cutoffs += other.cutoffs;
+        first_cutoffs += other.first_cutoffs;
+        qnodes += other.qnodes;
+        tb_hits += other.tb_hits;
+        return *this;
+    }
+};
+
+// Запись телеметрии одного хода бота. Заполняется Logic после каждого поиска,
+// номера партии и хода добавляет Game. Пишется в лог одной строкой JSON.
+struct search_record
+{
+    int game = 0;                  // номер партии с начала запуска
+    int turn = 0;                  // номер хода в партии
+    bool color = false;            // сторона бота
+    int level = 0;                 // Max_depth
+    const char* source = "search"; // откуда ход: search, book, tablebase, ponder
+    int depth = -1;                // последняя полностью завершённая итерация углубления
+    size_t nodes = 0;
+    search_counters counters;
+    tt_stats tt;
+    double score = 0;
+    vector<full_turn> pv;
+    double search_ms = 0; // время поиска, давшего ход (у пондеринга — фонового)
+    double time_ms = 0;   // время find_best_turn, которое ждала партия
+
+    // Строка JSON с полями записи; выключенные счётчики не пишутся
+    void write_json(ostream& out) const
+    {
+        nlohmann::json js;
+        js["game"] = game;
+        js["turn"] = turn;
+        js["color"] = color ? "black" : "white";
+        js["level"] = level;
+        js["source"] = source;
+        js["depth"] = depth;
+        js["nodes"] = nodes;
+        if constexpr ((TELEMETRY & TM_EVALS) != 0)
+            js["evals"] = counters.evals;
+        if constexpr ((TELEMETRY & TM_CUTOFFS) != 0)
+            js["cutoffs"] = counters.cutoffs;
+        if constexpr ((TELEMETRY & TM_FIRST_CUTOFFS) != 0)
+            js["first_cutoffs"] = counters.first_cutoffs;
+        if constexpr ((TELEMETRY & TM_QNODES) != 0)
+            js["qnodes"] = counters.qnodes;
+        if constexpr ((TELEMETRY & TM_TB_HITS) != 0)
+            js["tb_hits"] = counters.tb_hits;
+        js["tt_hits"] = tt.hits;
+        js["tt_misses"] = tt.misses;
+        js["tt_collisions"] = tt.collisions;
+        js["score"] = score;
+        vector<string> line;
+        for (const auto& turn : pv)
+            line.push_back(turn.notation());
+        js["pv"] = line;
+        js["search_ms"] = search_ms;
+        js["time_ms"] = time_ms;
+        js["nps"] = search_ms > 0 ? size_t(nodes / search_ms * 1000) : 0;
+        out << js.dump() << "\n";
+    }
+};
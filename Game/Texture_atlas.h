@@ -0,0 +1,231 @@
+#pragma once
+#include <algorithm>
+#include <string>
+
+#ifdef __APPLE__
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#else
+#include <SDL.h>
+#include <SDL_image.h>
+#endif
+
+using namespace std;
+
+// Картинки атласа
+enum class Sprite
+{
+    WHITE_PIECE,
+    BLACK_PIECE,
+    WHITE_QUEEN,
+    BLACK_QUEEN,
+    BACK,
+    REPLAY,
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW,
+    COUNT
+};
+
+// Все текстуры доски. Картинки из Textures/ декодируются с диска один раз в load()
+// и остаются в памяти как поверхности, поэтому при отрисовке файлы не читаются,
+// а после сброса устройства рендера текстуры пересоздаются из памяти (rebuild()).
+// Шашки, кнопки и картинки результата упакованы в одну текстуру (атлас) полками по высоте,
+// поэтому все они рисуются из одной текстуры и рендер объединяет их в один вызов.
+// Фон доски (3000x3000) в атлас не помещается и хранится отдельной текстурой.
+class Texture_atlas
+{
+  public:
+    ~Texture_atlas()
+    {
+        free();
+    }
+
+    // Декодирует все картинки из каталога dir и создаёт текстуры.
+    // false — файл не прочитан или текстуру не создать, причина в error().
+    bool load(SDL_Renderer* renderer, const string& dir)
+    {
+        free();
+        ren = renderer;
+        background_surface = decode(dir + BACKGROUND_FILE);
+        if (!background_surface)
+            return false;
+        for (int i = 0; i < SPRITES; ++i)
+        {
+            surfaces[i] = decode(dir + FILES[i]);
+            if (!surfaces[i])
+                return false;
+        }
+        return rebuild();
+    }
+
+    // Пересоздаёт текстуры из картинок в памяти, например после SDL_RENDER_DEVICE_RESET
+    bool rebuild()
+    {
+        destroy();
+        background = SDL_CreateTextureFromSurface(ren, background_surface);
+        if (!background)
+            return fail("SDL_CreateTextureFromSurface can't create board texture");
+
+        // Атлас не больше MAX_SIZE и предела рендера; если не помещается, картинки уменьшаются вдвое
+        SDL_RendererInfo info;
+        int max_w = MAX_SIZE, max_h = MAX_SIZE;
+        if (SDL_GetRendererInfo(ren, &info) == 0)
+        {
+            if (info.max_texture_width > 0)
+                max_w = min(max_w, info.max_texture_width);
+            if (info.max_texture_height > 0)
+                max_h = min(max_h, info.max_texture_height);
+        }
+        double scale = 1;
+        int atlas_w = 0, atlas_h = 0;
+        while (!pack(max_w, max_h, scale, atlas_w, atlas_h))
+        {
+            scale /= 2;
+            if (scale < MIN_SCALE)
+                return fail("textures don't fit into the atlas");
+        }
+
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, atlas_w, atlas_h, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface)
+            return fail("SDL_CreateRGBSurfaceWithFormat can't create atlas surface");
+        for (int i = 0; i < SPRITES; ++i)
+        {
+            const int res = scale == 1 ? SDL_BlitSurface(surfaces[i], NULL, surface, &rects[i])
+                                       : SDL_BlitScaled(surfaces[i], NULL, surface, &rects[i]);
+            if (res != 0)
+            {
+                SDL_FreeSurface(surface);
+                return fail("can't copy " + string(FILES[i]) + " into the atlas");
+            }
+        }
+        atlas = SDL_CreateTextureFromSurface(ren, surface);
+        SDL_FreeSurface(surface);
+        if (!atlas)
+            return fail("SDL_CreateTextureFromSurface can't create atlas texture");
+        SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+        return true;
+    }
+
+    // Рисует фон доски в прямоугольник dst (NULL — во всё окно или текстуру кадра)
+    void draw_background(const SDL_Rect* dst) const
+    {
+        SDL_RenderCopy(ren, background, NULL, dst);
+    }
+
+    // Рисует картинку атласа в прямоугольник dst
+    void draw(const Sprite sprite, const SDL_Rect& dst) const
+    {
+        SDL_RenderCopy(ren, atlas, &rects[int(sprite)], &dst);
+    }
+
+    const string& error() const
+    {
+        return error_text;
+    }
+
+    // Освобождает текстуры, картинки в памяти остаются
+    void destroy()
+    {
+        if (atlas)
+            SDL_DestroyTexture(atlas);
+        if (background)
+            SDL_DestroyTexture(background);
+        atlas = nullptr;
+        background = nullptr;
+    }
+
+    // Освобождает текстуры и картинки
+    void free()
+    {
+        destroy();
+        if (background_surface)
+            SDL_FreeSurface(background_surface);
+        background_surface = nullptr;
+        for (auto& surface : surfaces)
+        {
+            if (surface)
+                SDL_FreeSurface(surface);
+            surface = nullptr;
+        }
+    }
+
+  private:
+    // Читает картинку и приводит её к RGBA32, чтобы копирование в атлас не меняло формат.
+    // Копирование без смешивания: пиксели вместе с прозрачностью переносятся в атлас как есть.
+    SDL_Surface* decode(const string& path)
+    {
+        SDL_Surface* loaded = IMG_Load(path.c_str());
+        if (!loaded)
+        {
+            fail("IMG_Load can't load " + path);
+            return nullptr;
+        }
+        SDL_Surface* res = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (!res)
+        {
+            fail("SDL_ConvertSurfaceFormat can't convert " + path);
+            return nullptr;
+        }
+        SDL_SetSurfaceBlendMode(res, SDL_BLENDMODE_NONE);
+        return res;
+    }
+
+    // Раскладывает картинки, уменьшенные в scale раз, по полкам: от высоких к низким,
+    // слева направо, пока полка не кончится. Считает размер атласа, false — не помещается.
+    bool pack(const int max_w, const int max_h, const double scale, int& atlas_w, int& atlas_h)
+    {
+        int order[SPRITES];
+        for (int i = 0; i < SPRITES; ++i)
+            order[i] = i;
+        sort(order, order + SPRITES, [&](const int a, const int b) { return surfaces[a]->h > surfaces[b]->h; });
+
+        int x = PADDING, y = PADDING, shelf_h = 0;
+        atlas_w = 0;
+        for (const int i : order)
+        {
+            const int w = max(1, int(surfaces[i]->w * scale)), h = max(1, int(surfaces[i]->h * scale));
+            if (x + w + PADDING > max_w)
+            {
+                x = PADDING;
+                y += shelf_h + PADDING;
+                shelf_h = 0;
+            }
+            if (x + w + PADDING > max_w)
+                return false;
+            rects[i] = SDL_Rect{ x, y, w, h };
+            x += w + PADDING;
+            shelf_h = max(shelf_h, h);
+            atlas_w = max(atlas_w, x);
+        }
+        atlas_h = y + shelf_h + PADDING;
+        return atlas_h <= max_h;
+    }
+
+    bool fail(const string& text)
+    {
+        error_text = text;
+        return false;
+    }
+
+    static const int SPRITES = int(Sprite::COUNT);
+    // Наибольшая сторона атласа: 4096 поддерживают практически все видеокарты
+    static const int MAX_SIZE = 4096;
+    // Отступ между картинками, чтобы при масштабировании не подмешивались пиксели соседей
+    static const int PADDING = 2;
+    static constexpr double MIN_SCALE = 1.0 / 16;
+    static constexpr const char* BACKGROUND_FILE = "board.png";
+    static constexpr const char* FILES[SPRITES] = { "piece_white.png", "piece_black.png", "queen_white.png",
+                                                    "queen_black.png", "back.png",        "replay.png",
+                                                    "white_wins.png",  "black_wins.png",  "draw.png" };
+
+    SDL_Renderer* ren = nullptr;
+    SDL_Surface* background_surface = nullptr;
+    SDL_Surface* surfaces[SPRITES] = {};
+    SDL_Texture* background = nullptr;
+    SDL_Texture* atlas = nullptr;
+    // Место каждой картинки в атласе
+    SDL_Rect rects[SPRITES] = {};
+    string error_text;
+};
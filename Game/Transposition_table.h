@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../Models/Position.h"
+
+using namespace std;
+
+// Тип оценки, сохранённой в таблице
+enum class Bound : uint8_t
+{
+    EXACT, // точная оценка
+    LOWER, // оценка не меньше сохранённой (отсечение сверху)
+    UPPER  // оценка не больше сохранённой (все ходы оказались хуже окна)
+};
+
+// Запись таблицы транспозиций в распакованном виде
+struct tt_entry
+{
+    double score = 0;                         // оценка позиции
+    int best_from = -1;                       // лучший найденный ход: начальная клетка
+    int best_to = -1;                         // и конечная клетка, -1 — хода нет
+    int depth = -1;                           // оставшаяся глубина поиска
+    Bound bound = Bound::EXACT;               // тип оценки
+};
+
+// Счётчики обращений к таблице. Каждый поток поиска ведёт свои, потом они складываются.
+struct tt_stats
+{
+    size_t hits = 0;       // позиция найдена
+    size_t misses = 0;     // ячейка пуста
+    size_t collisions = 0; // ячейка занята другой позицией (или читалась во время записи)
+
+    tt_stats& operator+=(const tt_stats& other)
+    {
+        hits += other.hits;
+        misses += other.misses;
+        collisions += other.collisions;
+        return *this;
+    }
+};
+
+// Таблица транспозиций фиксированного размера с заменой по глубине.
+// Размер — степень двойки, индекс ячейки — младшие биты ключа.
+// Таблица общая для всех потоков поиска и работает без блокировок:
+// в ячейке хранится ключ, сложенный по xor с данными, поэтому
+// ячейка, прочитанная во время чужой записи, просто не совпадёт по ключу.
+class Transposition_table
+{
+  public:
+    Transposition_table() = default;
+
+    explicit Transposition_table(const size_t size_mb)
+    {
+        resize(size_mb);
+    }
+
+    // Выделяет таблицу не больше size_mb мегабайт, 0 отключает таблицу
+    void resize(const size_t size_mb)
+    {
+        size_t count = 0;
+        const size_t max_count = size_mb * 1024 * 1024 / sizeof(slot);
+        if (max_count)
+        {
+            count = 1;
+            while (count * 2 <= max_count)
+                count *= 2;
+        }
+        vector<slot>(count).swap(slots);
+        mask = count ? count - 1 : 0;
+    }
+
+    // Начало нового поиска: записи прошлых поисков становятся кандидатами на замену
+    void new_search()
+    {
+        ++age;
+    }
+
+    // Поиск позиции по ключу. Возвращает true и заполняет entry, если позиция есть в таблице.
+    bool probe(const uint64_t key, tt_entry& entry, tt_stats& stats) const
+    {
+        if (slots.empty())
+            return false;
+        const slot& sl = slots[key & mask];
+        const uint64_t data = sl.data.load(memory_order_relaxed);
+        const uint64_t score = sl.score.load(memory_order_relaxed);
+        const uint64_t check = sl.check.load(memory_order_relaxed);
+        if (!(data & 0xFF))
+        {
+            ++stats.misses;
+            return false;
+        }
+        if ((check ^ data ^ score) != key)
+        {
+            ++stats.collisions;
+            return false;
+        }
+        ++stats.hits;
+        memcpy(&entry.score, &score, sizeof(double));
+        entry.depth = int(data & 0xFF) - 1;
+        entry.bound = Bound((data >> 8) & 3);
+        entry.best_from = entry.best_to = -1;
+        if (data & (uint64_t(1) << 28))
+        {
+            entry.best_from = int((data >> 18) & 31);
+            entry.best_to = int((data >> 23) & 31);
+        }
+        return true;
+    }
+
+    // Сохранение результата. Запись текущего поиска с большей глубиной не вытесняется.
+    void store(const uint64_t key, const double score, const int depth, const Bound bound, const full_turn& best)
+    {
+        if (slots.empty())
+            return;
+        slot& sl = slots[key & mask];
+        const uint64_t old = sl.data.load(memory_order_relaxed);
+        if ((old & 0xFF) && ((old >> 10) & 0xFF) == age && depth < int(old & 0xFF) - 1)
+            return;
+        uint64_t data = uint64_t(depth + 1) | (uint64_t(bound) << 8) | (uint64_t(age) << 10);
+        if (best.from != -1)
+        {
+            data |= uint64_t(best.from) << 18;
+            data |= uint64_t(best.to()) << 23;
+            data |= uint64_t(1) << 28;
+        }
+        uint64_t score_bits;
+        memcpy(&score_bits, &score, sizeof(double));
+        sl.data.store(data, memory_order_relaxed);
+        sl.score.store(score_bits, memory_order_relaxed);
+        sl.check.store(key ^ data ^ score_bits, memory_order_relaxed);
+    }
+
+  private:
+    // Ячейка таблицы. data: биты 0-7 — глубина + 1 (0 — пусто), 8-9 — тип оценки,
+    // 10-17 — номер поиска, 18-22 и 23-27 — клетки лучшего хода, 28 — есть лучший ход.
+    struct slot
+    {
+        atomic<uint64_t> check{0};
+        atomic<uint64_t> score{0};
+        atomic<uint64_t> data{0};
+    };
+
+    vector<slot> slots;
+    size_t mask = 0;
+    uint8_t age = 0;
+};
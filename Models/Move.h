@@ -11,6 +11,9 @@ struct move_pos
     POS_T x2, y2;           // конечная клетка хода (координаты "куда")
     POS_T xb = -1, yb = -1; // координаты побитой шашки; -1 означает, что взятия нет
 
+    // Пустой ход, нужен для хранения в массивах фиксированного размера
+    move_pos() = default;
+
     // Конструктор для обычного хода без взятия
     move_pos(const POS_T x, const POS_T y, const POS_T x2, const POS_T y2)
         : x(x), y(y), x2(x2), y2(y2)
@@ -0,0 +1,81 @@
+#pragma once
+#include <stdexcept>
+
+#include "Position.h"
+
+// Максимальное число ходов в одной позиции (с большим запасом для позиций с дамками)
+const int MAX_TURNS = 256;
+
+// Список полных ходов фиксированной ёмкости. Размещается на стеке у вызывающего,
+// поэтому генерация ходов не обращается к куче и может идти параллельно.
+struct move_list
+{
+    // Ячейки не инициализируются: конструктор full_turn на каждом узле поиска
+    // заполнял бы все MAX_TURNS ячеек, хотя используются только первые count.
+    union
+    {
+        full_turn turns[MAX_TURNS];
+    };
+    int count = 0;
+    // true, если в списке только удары
+    bool have_beats = false;
+
+    move_list()
+    {
+    }
+
+    void clear()
+    {
+        count = 0;
+        have_beats = false;
+    }
+
+    void push_back(const full_turn& turn)
+    {
+        if (count == MAX_TURNS)
+        {
+            throw std::length_error("move_list capacity exceeded");
+        }
+        turns[count++] = turn;
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    int size() const
+    {
+        return count;
+    }
+
+    full_turn& operator[](const int i)
+    {
+        return turns[i];
+    }
+
+    const full_turn& operator[](const int i) const
+    {
+        return turns[i];
+    }
+
+    full_turn* begin()
+    {
+        return turns;
+    }
+
+    full_turn* end()
+    {
+        return turns + count;
+    }
+
+    const full_turn* begin() const
+    {
+        return turns;
+    }
+
+    const full_turn* end() const
+    {
+        return turns + count;
+    }
+};
@@ -0,0 +1,532 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Move.h"
+
+using namespace std;
+
+// Маски строк превращения: 0-я для белых, 7-я для чёрных
+const uint32_t WHITE_PROMOTION_ROW_MASK = 0x0000000Fu;
+const uint32_t BLACK_PROMOTION_ROW_MASK = 0xF0000000u;
+
+// Количество установленных битов
+inline int bit_count(uint32_t b)
+{
+    b = b - ((b >> 1) & 0x55555555u);
+    b = (b & 0x33333333u) + ((b >> 2) & 0x33333333u);
+    return int((((b + (b >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// Номер младшего установленного бита (b != 0)
+inline int lowest_bit(const uint32_t b)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, b);
+    return int(idx);
+#else
+    return __builtin_ctz(b);
+#endif
+}
+
+// Извлекает и снимает младший бит маски
+inline int pop_lowest_bit(uint32_t& b)
+{
+    const int s = lowest_bit(b);
+    b &= b - 1;
+    return s;
+}
+
+// Генератор псевдослучайных 64-битных чисел (splitmix64) для ключей Zobrist
+constexpr uint64_t splitmix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Ключи Zobrist: [тип фигуры - 1][клетка], тип в кодировке матрицы (1..4)
+constexpr array<array<uint64_t, 32>, 4> make_zobrist_keys()
+{
+    array<array<uint64_t, 32>, 4> keys{};
+    uint64_t state = 0x436865636B657273ull;
+    for (int t = 0; t < 4; ++t)
+    {
+        for (int s = 0; s < 32; ++s)
+            keys[t][s] = splitmix64(state);
+    }
+    return keys;
+}
+
+constexpr array<array<uint64_t, 32>, 4> ZOBRIST_KEYS = make_zobrist_keys();
+// Ключ очереди хода чёрных
+const uint64_t ZOBRIST_BLACK_TURN = 0x8A5CD789635D2DFFull;
+
+// Позиционный вес фигуры [тип - 1][клетка] для оценки NumberAndPotential:
+// шашка — число строк, пройденных к превращению (0..6), дамка — 0.
+constexpr array<array<int8_t, 32>, 4> make_potential()
+{
+    array<array<int8_t, 32>, 4> res{};
+    for (int s = 0; s < 32; ++s)
+    {
+        res[0][s] = int8_t(7 - (s >> 2));
+        res[1][s] = int8_t(s >> 2);
+    }
+    return res;
+}
+
+constexpr array<array<int8_t, 32>, 4> POTENTIAL = make_potential();
+
+// Веса клеток оценки [тип - 1][клетка] в единицах SQUARE_WEIGHT_UNIT доли шашки.
+// Целые, чтобы суммы после make_turn/unmake_turn точно совпадали с пересчётом.
+// Задаются оценкой (Evaluator::attach), у остальных позиций все веса нулевые.
+using square_weights = array<array<int32_t, 32>, 4>;
+const double SQUARE_WEIGHT_UNIT = 1e-4;
+inline const square_weights NO_SQUARE_WEIGHTS{};
+
+// Счётчики для оценки позиции, которые make_turn/unmake_turn поддерживают на ходу,
+// чтобы оценка листа не пересчитывала доску: число фигур каждого типа,
+// сумма позиционных весов и сумма весов клеток фигур каждого цвета.
+struct eval_counters
+{
+    uint8_t count[4] = {}; // [тип - 1]: белые шашки, чёрные шашки, белые дамки, чёрные дамки
+    int16_t potential[2] = {}; // [цвет]: сумма POTENTIAL по фигурам цвета
+    int32_t square[2] = {};    // [цвет]: сумма весов клеток weights по фигурам цвета
+    const square_weights* weights = &NO_SQUARE_WEIGHTS;
+
+    void add(const int type, const int s)
+    {
+        ++count[type - 1];
+        potential[(type - 1) & 1] += POTENTIAL[type - 1][s];
+        square[(type - 1) & 1] += (*weights)[type - 1][s];
+    }
+
+    void remove(const int type, const int s)
+    {
+        --count[type - 1];
+        potential[(type - 1) & 1] -= POTENTIAL[type - 1][s];
+        square[(type - 1) & 1] -= (*weights)[type - 1][s];
+    }
+
+    // Фигуры цвета color: шашки и дамки
+    int men(const bool color) const
+    {
+        return count[color];
+    }
+
+    int kings(const bool color) const
+    {
+        return count[2 + color];
+    }
+
+    bool operator==(const eval_counters& other) const
+    {
+        return memcmp(this, &other, sizeof(*this)) == 0;
+    }
+
+    bool operator!=(const eval_counters& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Сведения, нужные для точного отката хода: тип побитой фигуры, факт превращения и прежний ключ
+struct turn_undo
+{
+    uint64_t hash = 0;         // ключ Zobrist до хода
+    eval_counters counters;    // счётчики оценки до хода
+    bool beaten_king = false;  // побитая фигура была дамкой
+    bool promoted = false;     // шашка превратилась в дамку этим ходом
+    uint32_t beaten_kings = 0; // дамки среди фигур, побитых полным ходом
+};
+
+// Наибольшее число ударов в одной серии: у соперника не больше 12 фигур
+const int MAX_BEATS = 12;
+
+struct full_turn;
+
+// Компактное представление позиции: 32 игровые (тёмные) клетки доски.
+// Клетка (x, y) с (x + y) % 2 == 1 имеет номер x * 4 + y / 2,
+// поэтому обход номеров 0..31 совпадает с построчным обходом матрицы.
+struct Position
+{
+    uint32_t white = 0; // белые фигуры (шашки и дамки)
+    uint32_t black = 0; // чёрные фигуры (шашки и дамки)
+    uint32_t kings = 0; // дамки обоих цветов
+    uint64_t hash = 0;  // ключ Zobrist, поддерживается make_turn/unmake_turn
+    eval_counters counters; // счётчики для оценки, поддерживаются make_turn/unmake_turn
+
+    Position() = default;
+
+    // Построение позиции по матрице доски (1 - белая, 2 - чёрная, 3 - белая дамка, 4 - чёрная дамка)
+    explicit Position(const vector<vector<POS_T>>& mtx)
+    {
+        for (int s = 0; s < 32; ++s)
+        {
+            const POS_T type = mtx[sq_row(s)][sq_col(s)];
+            if (!type)
+                continue;
+            const uint32_t b = bit(s);
+            if (type % 2)
+                white |= b;
+            else
+                black |= b;
+            if (type > 2)
+                kings |= b;
+        }
+        recalc();
+    }
+
+    // Стартовая расстановка, как в Board::make_start_mtx: чёрные в строках 0-2, белые в строках 5-7
+    static Position make_start()
+    {
+        Position pos;
+        pos.black = 0x00000FFFu;
+        pos.white = 0xFFF00000u;
+        pos.recalc();
+        return pos;
+    }
+
+    // Полный пересчёт ключа Zobrist по маскам
+    uint64_t calc_hash() const
+    {
+        uint64_t res = 0;
+        for (uint32_t rest = occupied(); rest;)
+        {
+            const int s = pop_lowest_bit(rest);
+            res ^= ZOBRIST_KEYS[type(s) - 1][s];
+        }
+        return res;
+    }
+
+    // Полный пересчёт счётчиков оценки по маскам
+    eval_counters calc_counters() const
+    {
+        eval_counters res;
+        res.weights = counters.weights;
+        for (uint32_t rest = occupied(); rest;)
+        {
+            const int s = pop_lowest_bit(rest);
+            res.add(type(s), s);
+        }
+        return res;
+    }
+
+    // Пересчёт ключа и счётчиков после того, как маски заданы напрямую
+    void recalc()
+    {
+        hash = calc_hash();
+        counters = calc_counters();
+    }
+
+    // Задаёт веса клеток для счётчиков и пересчитывает счётчики
+    void set_square_weights(const square_weights* weights)
+    {
+        counters.weights = weights;
+        counters = calc_counters();
+    }
+
+    // Обратное преобразование в матрицу 8x8 для Board и отрисовки
+    vector<vector<POS_T>> to_mtx() const
+    {
+        vector<vector<POS_T>> mtx(8, vector<POS_T>(8, 0));
+        for (int s = 0; s < 32; ++s)
+            mtx[sq_row(s)][sq_col(s)] = type(s);
+        return mtx;
+    }
+
+    // Тип фигуры на клетке в кодировке матрицы, 0 - пусто
+    POS_T type(const int s) const
+    {
+        const uint32_t b = bit(s);
+        if (!((white | black) & b))
+            return 0;
+        return POS_T((white & b) ? 1 : 2) + ((kings & b) ? 2 : 0);
+    }
+
+    uint32_t occupied() const
+    {
+        return white | black;
+    }
+
+    // Фигуры цвета color (0 - белые, 1 - чёрные, как в Logic::find_turns)
+    uint32_t pieces(const bool color) const
+    {
+        return color ? black : white;
+    }
+
+    // Выполняет ход на месте.
+    // 1. Если ход является ударом (xb != -1) — снимаем побитую шашку.
+    // 2. Перемещаем фигуру (одна операция xor на маске цвета и, для дамки, на маске дамок).
+    // 3. Шашка, дошедшая до последней строки, становится дамкой.
+    // Возвращает данные для unmake_turn.
+    turn_undo make_turn(const move_pos& turn)
+    {
+        turn_undo undo;
+        undo.hash = hash;
+        undo.counters = counters;
+        const int s_from = sq(turn.x, turn.y);
+        const int s_to = sq(turn.x2, turn.y2);
+        const POS_T type_from = type(s_from);
+        if (turn.xb != -1)
+        {
+            const int s_beaten = sq(turn.xb, turn.yb);
+            const uint32_t beaten = bit(s_beaten);
+            hash ^= ZOBRIST_KEYS[type(s_beaten) - 1][s_beaten];
+            counters.remove(type(s_beaten), s_beaten);
+            undo.beaten_king = (kings & beaten) != 0;
+            white &= ~beaten;
+            black &= ~beaten;
+            kings &= ~beaten;
+        }
+        const uint32_t from = bit(s_from);
+        const uint32_t to = bit(s_to);
+        const bool is_white = (white & from) != 0;
+        if (is_white)
+            white ^= from | to;
+        else
+            black ^= from | to;
+        if (kings & from)
+        {
+            kings ^= from | to;
+        }
+        else if (to & (is_white ? WHITE_PROMOTION_ROW_MASK : BLACK_PROMOTION_ROW_MASK))
+        {
+            kings |= to;
+            undo.promoted = true;
+        }
+        const POS_T type_to = POS_T(type_from + (undo.promoted ? 2 : 0));
+        hash ^= ZOBRIST_KEYS[type_from - 1][s_from] ^ ZOBRIST_KEYS[type_to - 1][s_to];
+        counters.remove(type_from, s_from);
+        counters.add(type_to, s_to);
+        return undo;
+    }
+
+    // Выполняет полный ход (тихий ход или всю серию ударов) за одну операцию
+    turn_undo make_turn(const full_turn& turn);
+
+    // Откатывает полный ход, выполненный make_turn
+    void unmake_turn(const full_turn& turn, const turn_undo& undo);
+
+    // Точно откатывает ход, выполненный make_turn: возвращает фигуру,
+    // отменяет превращение и восстанавливает побитую фигуру соперника.
+    void unmake_turn(const move_pos& turn, const turn_undo& undo)
+    {
+        const uint32_t from = bit(sq(turn.x, turn.y));
+        const uint32_t to = bit(sq(turn.x2, turn.y2));
+        const bool is_white = (white & to) != 0;
+        if (is_white)
+            white ^= from | to;
+        else
+            black ^= from | to;
+        if (undo.promoted)
+            kings &= ~to;
+        else if (kings & to)
+            kings ^= from | to;
+        if (turn.xb != -1)
+        {
+            const uint32_t beaten = bit(sq(turn.xb, turn.yb));
+            if (is_white)
+                black |= beaten;
+            else
+                white |= beaten;
+            if (undo.beaten_king)
+                kings |= beaten;
+        }
+        hash = undo.hash;
+        counters = undo.counters;
+    }
+
+    bool operator==(const Position& other) const
+    {
+        return white == other.white && black == other.black && kings == other.kings;
+    }
+
+    bool operator!=(const Position& other) const
+    {
+        return !(*this == other);
+    }
+
+    static uint32_t bit(const int s)
+    {
+        return uint32_t(1) << s;
+    }
+
+    static int sq(const POS_T x, const POS_T y)
+    {
+        return x * 4 + y / 2;
+    }
+
+    static POS_T sq_row(const int s)
+    {
+        return POS_T(s >> 2);
+    }
+
+    static POS_T sq_col(const int s)
+    {
+        return POS_T(((s & 3) << 1) | (((s >> 2) & 1) ^ 1));
+    }
+
+    // Название клетки в шашечной нотации: белые внизу, строка 0 матрицы — восьмая горизонталь
+    static string square_name(const int s)
+    {
+        return string{char('a' + sq_col(s)), char('8' - sq_row(s))};
+    }
+};
+
+// Направления по диагоналям в порядке обхода исходного генератора:
+// 0 - (-1, -1), 1 - (-1, +1), 2 - (+1, -1), 3 - (+1, +1).
+// Белые шашки ходят направлениями 0 и 1, чёрные - 2 и 3.
+constexpr array<array<int8_t, 4>, 32> make_steps()
+{
+    array<array<int8_t, 4>, 32> steps{};
+    for (int s = 0; s < 32; ++s)
+    {
+        const int x = s >> 2;
+        const int y = ((s & 3) << 1) | (((s >> 2) & 1) ^ 1);
+        for (int d = 0; d < 4; ++d)
+        {
+            const int x2 = x + ((d & 2) ? 1 : -1);
+            const int y2 = y + ((d & 1) ? 1 : -1);
+            steps[s][d] = (x2 < 0 || x2 > 7 || y2 < 0 || y2 > 7) ? int8_t(-1) : int8_t(x2 * 4 + y2 / 2);
+        }
+    }
+    return steps;
+}
+
+// Соседняя клетка в направлении d или -1, если это край доски
+constexpr array<array<int8_t, 4>, 32> SQUARE_STEPS = make_steps();
+
+// Полный ход фигуры: тихий ход или вся серия ударов, которую бьющая шашка обязана довести до конца.
+// Хранит клетки приземления и побитые клетки по порядку (номера 0..31, см. Position::sq),
+// отдельные шаги для Board и State восстанавливаются через hop(i).
+struct full_turn
+{
+    int8_t from = -1;           // начальная клетка
+    int8_t count = 0;           // число шагов: 1 у тихого хода, число ударов у серии
+    int8_t path[MAX_BEATS];     // клетка после каждого шага
+    int8_t beaten[MAX_BEATS];   // побитая каждым шагом клетка, -1 у тихого хода
+    uint32_t beaten_mask = 0;   // все побитые фигуры
+    bool promotion = false;     // шашка становится дамкой, в том числе посреди серии
+
+    // Конечная клетка хода
+    int to() const
+    {
+        return path[count - 1];
+    }
+
+    bool is_beat() const
+    {
+        return beaten_mask != 0;
+    }
+
+    // i-й шаг хода в координатах доски
+    move_pos hop(const int i) const
+    {
+        const int s = i ? path[i - 1] : from;
+        if (beaten[i] == -1)
+            return move_pos(Position::sq_row(s), Position::sq_col(s), Position::sq_row(path[i]),
+                            Position::sq_col(path[i]));
+        return move_pos(Position::sq_row(s), Position::sq_col(s), Position::sq_row(path[i]),
+                        Position::sq_col(path[i]), Position::sq_row(beaten[i]), Position::sq_col(beaten[i]));
+    }
+
+    // Запись хода: клетки через "-" для тихого хода и через ":" для серии ударов, например e3:c5:a3
+    string notation() const
+    {
+        string res = Position::square_name(from);
+        for (int i = 0; i < count; ++i)
+        {
+            res += beaten[i] == -1 ? '-' : ':';
+            res += Position::square_name(path[i]);
+        }
+        return res;
+    }
+
+    // Все шаги хода по порядку
+    vector<move_pos> hops() const
+    {
+        vector<move_pos> res;
+        for (int i = 0; i < count; ++i)
+            res.push_back(hop(i));
+        return res;
+    }
+
+    // Ходы равны, если приводят к одной и той же позиции:
+    // порядок ударов и промежуточные клетки не важны
+    bool operator==(const full_turn& other) const
+    {
+        return from == other.from && to() == other.to() && beaten_mask == other.beaten_mask &&
+               promotion == other.promotion;
+    }
+
+    bool operator!=(const full_turn& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Побитые фигуры снимаются все сразу, фигура переносится с начальной клетки на конечную
+// (они совпадают, если дамка вернулась на место), превращение берётся из хода.
+inline turn_undo Position::make_turn(const full_turn& turn)
+{
+    turn_undo undo;
+    undo.hash = hash;
+    undo.counters = counters;
+    const int s_from = turn.from, s_to = turn.to();
+    const POS_T type_from = type(s_from);
+    for (uint32_t rest = turn.beaten_mask; rest;)
+    {
+        const int s = pop_lowest_bit(rest);
+        const POS_T type_beaten = type(s);
+        hash ^= ZOBRIST_KEYS[type_beaten - 1][s];
+        counters.remove(type_beaten, s);
+    }
+    undo.beaten_kings = kings & turn.beaten_mask;
+    white &= ~turn.beaten_mask;
+    black &= ~turn.beaten_mask;
+    kings &= ~turn.beaten_mask;
+
+    const uint32_t from = bit(s_from), to = bit(s_to);
+    uint32_t& own = (white & from) ? white : black;
+    own = (own & ~from) | to;
+    if (kings & from)
+    {
+        kings = (kings & ~from) | to;
+    }
+    else if (turn.promotion)
+    {
+        kings |= to;
+        undo.promoted = true;
+    }
+    const POS_T type_to = POS_T(type_from + (undo.promoted ? 2 : 0));
+    hash ^= ZOBRIST_KEYS[type_from - 1][s_from] ^ ZOBRIST_KEYS[type_to - 1][s_to];
+    counters.remove(type_from, s_from);
+    counters.add(type_to, s_to);
+    return undo;
+}
+
+inline void Position::unmake_turn(const full_turn& turn, const turn_undo& undo)
+{
+    const uint32_t from = bit(turn.from), to = bit(turn.to());
+    const bool is_white = (white & to) != 0;
+    uint32_t& own = is_white ? white : black;
+    own = (own & ~to) | from;
+    if (undo.promoted)
+        kings &= ~to;
+    else if (kings & to)
+        kings = (kings & ~to) | from;
+    (is_white ? black : white) |= turn.beaten_mask;
+    kings |= undo.beaten_kings;
+    hash = undo.hash;
+    counters = undo.counters;
+}
@@ -0,0 +1,136 @@
+// Построение дебютной книги глубоким поиском, без окна и без SDL.
+// Использование: bookgen [полуходы] [уровень] [допуск] [файл]
+// По умолчанию книга на 8 полуходов, ходы оцениваются поиском уровня 8,
+// в книгу попадают ходы с оценкой не хуже лучшей на 0 шашек, файл — Book/book.bin.
+// Остальные настройки поиска (Optimization, TableSizeMB, Threads) берутся из settings.json.
+// Книга строится для обеих сторон: в позициях стороны книги продолжаются только ходы
+// книги, в позициях соперника — все его ходы, потому что он может сыграть любой.
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include "../Game/Config.h"
+#include "../Game/Logic.h"
+#include "../Game/Opening_book.h"
+
+using namespace std;
+
+class Book_builder
+{
+  public:
+    Book_builder(const Config* config, const int plies, const int level, const double margin)
+        : logic(config), plies(plies), level(level), margin(margin)
+    {
+        // Книга строится поиском, а не по уже готовой книге или таблицам
+        logic.book.close();
+        logic.tablebase = Tablebase();
+        logic.Max_depth = max(0, level - 1);
+    }
+
+    void run()
+    {
+        for (int side = 0; side < 2; ++side)
+            visit(Position::make_start(), 0, 0, side);
+    }
+
+    void write(const string& path) const
+    {
+        book_header header;
+        header.plies = uint8_t(plies);
+        header.level = uint8_t(level);
+        Opening_book::write(path, entries, header);
+        cout << "Book: " << visited.size() << " positions, " << entries.size() << " moves, " << searches
+             << " searches\n";
+    }
+
+  private:
+    // Обход позиций на глубине ply, side — сторона, для которой строится книга
+    void visit(const Position& pos, const bool color, const int ply, const bool side)
+    {
+        if (ply >= plies)
+            return;
+        move_list turns;
+        logic.find_turns(color, pos, turns);
+        if (turns.empty())
+            return;
+        if (color != side)
+        {
+            for (const auto& turn : turns)
+                visit_child(pos, color, turn, ply, side);
+            return;
+        }
+        if (!visited.insert(Opening_book::key(pos, color)).second)
+            return;
+
+        // Оценка каждого хода — минус оценка ответа соперника на уровне level - 1,
+        // то есть весь ход ищется на уровне level
+        vector<double> scores;
+        for (const auto& turn : turns)
+        {
+            Position child = pos;
+            child.make_turn(turn);
+            move_list replies;
+            logic.find_turns(!color, child, replies);
+            if (replies.empty())
+            {
+                scores.push_back(INF);
+                continue;
+            }
+            logic.find_best_turn(child, !color);
+            scores.push_back(-logic.score);
+            ++searches;
+        }
+        const double best = *max_element(scores.begin(), scores.end());
+        for (int i = 0; i < turns.size(); ++i)
+        {
+            if (scores[i] < best - margin)
+                continue;
+            // Лучший ход получает вес 1000, ход на границе допуска — 1
+            const int weight = margin > 0 ? 1 + int(lround(999 * (1 - (best - scores[i]) / margin))) : 1000;
+            entries.push_back(Opening_book::make_entry(pos, color, turns[i], weight));
+            visit_child(pos, color, turns[i], ply, side);
+        }
+        if (visited.size() % 100 == 0)
+            cout << visited.size() << " positions, " << entries.size() << " moves\n";
+    }
+
+    void visit_child(const Position& pos, const bool color, const full_turn& turn, const int ply, const bool side)
+    {
+        Position child = pos;
+        child.make_turn(turn);
+        visit(child, !color, ply + 1, side);
+    }
+
+    Logic logic;
+    int plies;
+    int level;
+    double margin;
+    unordered_set<uint64_t> visited;
+    vector<book_entry> entries;
+    size_t searches = 0;
+};
+
+int main(int argc, char* argv[])
+{
+    Config config;
+    const int plies = argc > 1 ? atoi(argv[1]) : 8;
+    const int level = argc > 2 ? atoi(argv[2]) : 8;
+    const double margin = argc > 3 ? atof(argv[3]) : 0;
+    const string path = argc > 4 ? argv[4] : project_path + "Book/book.bin";
+
+    const auto dir = filesystem::path(path).parent_path();
+    if (!dir.empty())
+        filesystem::create_directories(dir);
+
+    auto start = chrono::steady_clock::now();
+    Book_builder builder(&config, plies, level, margin);
+    builder.run();
+    builder.write(path);
+    auto end = chrono::steady_clock::now();
+    cout << "Time: " << int(chrono::duration<double>(end - start).count()) << " sec\n";
+    return 0;
+}
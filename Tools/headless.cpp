@@ -0,0 +1,156 @@
+// Матч бот против бота без окна и без SDL.
+// Использование: headless [число партий] [уровень бота A] [уровень бота B] [оценка A] [оценка B]
+// По умолчанию играется 10 партий, уровни берутся из WhiteBotLevel и BlackBotLevel,
+// оценка (NumberOnly / NumberAndPotential) — из BotScoringType
+// в settings.json, остальные настройки бота — оттуда же. Боты меняются цветами
+// каждую партию, итог считается для бота A.
+// После матча позиции первой партии пересчитываются ботом A с упорядочиванием ходов
+// и без него, чтобы показать, сколько узлов экономит упорядочивание на той же глубине.
+// Телеметрия каждого хода пишется в TelemetryPath.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "../Game/Async_log.h"
+#include "../Game/Config.h"
+#include "../Game/Logic.h"
+
+using namespace std;
+
+// Статистика одного бота за весь матч
+struct bot_stats
+{
+    int level = 0;
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    size_t moves = 0;
+    size_t nodes = 0;
+    double time_ms = 0;
+};
+
+// Играет одну партию, bots[0] — белые, bots[1] — чёрные.
+// Возвращает результат в кодировке Board::show_final: 0 — ничья, 1 — победа белых, 2 — победа чёрных.
+// Если передан positions, в него записываются все позиции партии перед ходом бота.
+int play_game(Logic* bots[2], bot_stats* stats[2], const int max_turns, const int game, Async_log& telemetry,
+              vector<pair<Position, bool>>* positions = nullptr)
+{
+    Position pos = Position::make_start();
+    move_list turns;
+    int turn_num = -1;
+    while (++turn_num < max_turns)
+    {
+        const bool color = turn_num % 2;
+        bots[color]->find_turns(color, pos, turns);
+        if (turns.empty())
+            return color ? 1 : 2;
+        if (positions)
+            positions->emplace_back(pos, color);
+
+        auto start = chrono::steady_clock::now();
+        const full_turn turn = bots[color]->find_best_turn(pos, color);
+        auto end = chrono::steady_clock::now();
+        stats[color]->time_ms += chrono::duration<double, milli>(end - start).count();
+        stats[color]->nodes += bots[color]->nodes;
+        ++stats[color]->moves;
+        search_record record = bots[color]->telemetry;
+        record.game = game;
+        record.turn = turn_num;
+        telemetry.post([record](ostream& out) { record.write_json(out); });
+
+        pos.make_turn(turn);
+    }
+    return 0;
+}
+
+// Суммарное число узлов поиска по позициям на фиксированной глубине,
+// каждый раз с новой таблицей транспозиций, без лимита времени, книги и таблиц эндшпиля
+size_t count_nodes(const Config* config, const vector<pair<Position, bool>>& positions, const int level,
+                   const bool move_ordering)
+{
+    size_t nodes = 0;
+    for (const auto& p : positions)
+    {
+        Logic logic(config);
+        logic.Max_depth = level;
+        logic.search_fixed_depth();
+        logic.move_ordering = move_ordering;
+        logic.find_best_turn(p.first, p.second);
+        nodes += logic.nodes;
+    }
+    return nodes;
+}
+
+void print_stats(const char* name, const bot_stats& st)
+{
+    const double avg_ms = st.moves ? st.time_ms / st.moves : 0;
+    const double nps = st.time_ms > 0 ? st.nodes / st.time_ms * 1000 : 0;
+    cout << "Bot " << name << " (level " << st.level << "): " << st.wins << " wins, " << st.draws << " draws, "
+         << st.losses << " losses, avg move time " << avg_ms << " millisec, " << size_t(nps) << " nodes/sec\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Config config;
+    const int games = argc > 1 ? atoi(argv[1]) : 10;
+    bot_stats a, b;
+    a.level = argc > 2 ? atoi(argv[2]) : config.get().bot.level[0];
+    b.level = argc > 3 ? atoi(argv[3]) : config.get().bot.level[1];
+    const int max_turns = config.get().game.max_turns;
+    Async_log telemetry;
+    if (!config.get().game.telemetry_path.empty())
+        telemetry.open(project_path + config.get().game.telemetry_path, false);
+
+    Logic logic_a(&config), logic_b(&config);
+    logic_a.Max_depth = a.level;
+    logic_b.Max_depth = b.level;
+    if (argc > 4)
+        logic_a.evaluator.set_scoring_type(argv[4]);
+    if (argc > 5)
+        logic_b.evaluator.set_scoring_type(argv[5]);
+
+    vector<pair<Position, bool>> positions;
+    for (int game = 0; game < games; ++game)
+    {
+        // В чётных партиях A играет белыми, в нечётных — чёрными
+        const bool a_is_black = game % 2;
+        Logic* bots[2] = {a_is_black ? &logic_b : &logic_a, a_is_black ? &logic_a : &logic_b};
+        bot_stats* stats[2] = {a_is_black ? &b : &a, a_is_black ? &a : &b};
+
+        const int res = play_game(bots, stats, max_turns, game, telemetry, game == 0 ? &positions : nullptr);
+        if (res == 0)
+        {
+            ++a.draws;
+            ++b.draws;
+        }
+        else if ((res == 2) == a_is_black)
+        {
+            ++a.wins;
+            ++b.losses;
+        }
+        else
+        {
+            ++a.losses;
+            ++b.wins;
+        }
+        cout << "Game " << game + 1 << ": " << (res == 0 ? "draw" : (res == 1 ? "white wins" : "black wins"))
+             << " (A plays " << (a_is_black ? "black" : "white") << ")\n";
+    }
+
+    print_stats("A", a);
+    print_stats("B", b);
+
+    if (!positions.empty())
+    {
+        const size_t ordered = count_nodes(&config, positions, a.level, true);
+        const size_t unordered = count_nodes(&config, positions, a.level, false);
+        cout << "Move ordering, level " << a.level << ", " << positions.size() << " positions: " << ordered
+             << " nodes, without ordering: " << unordered << " nodes";
+        if (unordered)
+            cout << " (" << 100.0 - 100.0 * ordered / unordered << "% fewer)";
+        cout << "\n";
+    }
+    return 0;
+}
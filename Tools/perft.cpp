@@ -0,0 +1,312 @@
+// Perft: число листьев дерева ходов до глубины N, без окна и без SDL.
+// Использование: perft [глубина] [таблица, МБ] [проверка make/unmake: 0/1]
+// Считает дерево для начальной позиции и набора сохранённых позиций и сравнивает
+// результат с эталонными числами: любой изменённый генератор ходов должен их повторить.
+// Серия ударов — один ход, серии, приводящие к одной позиции, считаются один раз
+// (как их видит бот, Rules::find_turns с unique). По умолчанию глубина 9, без таблицы.
+// С таблицей уже посчитанные поддеревья (позиция, очередь хода, глубина) берутся из неё.
+// Проверка сравнивает после каждого хода ключ Zobrist и счётчики оценки с полным пересчётом,
+// а после отката — позицию с исходной. С проверкой также проверяется история партии State
+// (см. check_history).
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Game/Rules.h"
+#include "../Game/State.h"
+
+using namespace std;
+
+// Сохранённая позиция: клетки 0..31 построчно сверху вниз
+// ('w' / 'b' — белая / чёрная шашка, 'W' / 'B' — дамки, '.' — пусто),
+// очередь хода и эталонные числа для глубин 1, 2, ...
+// Эталоны посчитаны генератором Rules (серии ударов целиком) и совпадают в режимах с таблицей
+// и с проверкой make/unmake. До глубины 7 они сверены с исходными правилами Logic::find_turns
+// (до перехода на битборды) для всех пяти позиций.
+struct perft_position
+{
+    string name;
+    string board;
+    bool color;
+    vector<uint64_t> counts;
+};
+
+const vector<perft_position> POSITIONS = {
+    {"start", "bbbbbbbbbbbb........wwwwwwwwwwww", 0,
+     {7, 49, 302, 1469, 7482, 37986, 190146, 929978, 4571311, 22480790, 111223865}},
+    {"middlegame", "bbbb...b..bwb.b.w..ww..w...ww.ww", 1,
+     {1, 7, 25, 99, 443, 2095, 10758, 55887, 292641, 1619886, 8449590}},
+    {"white king", "Wbbb...bb..bb..bww....w.w.wwww..", 1,
+     {1, 2, 15, 139, 868, 7200, 41543, 316114, 1734806, 12279895, 65384212}},
+    {"kings", ".......bb.bb...w...b.Bww..w.....", 1,
+     {2, 5, 34, 95, 585, 1286, 7374, 22681, 158077, 712018, 5261998}},
+    {"endgame", ".W.................bB...W.......", 1,
+     {1, 6, 42, 306, 2415, 16718, 129392, 915856, 7157649, 50887931, 399129019}},
+};
+
+Position parse(const string& board)
+{
+    if (board.size() != 32)
+        throw runtime_error("bad position: " + board);
+    Position pos;
+    for (int s = 0; s < 32; ++s)
+    {
+        const uint32_t b = Position::bit(s);
+        switch (board[s])
+        {
+        case 'W':
+            pos.kings |= b;
+            [[fallthrough]];
+        case 'w':
+            pos.white |= b;
+            break;
+        case 'B':
+            pos.kings |= b;
+            [[fallthrough]];
+        case 'b':
+            pos.black |= b;
+            break;
+        case '.':
+            break;
+        default:
+            throw runtime_error("bad position: " + board);
+        }
+    }
+    pos.recalc();
+    return pos;
+}
+
+// Таблица уже посчитанных поддеревьев, запись заменяется всегда
+class Perft_table
+{
+  public:
+    explicit Perft_table(const size_t size_mb)
+    {
+        size_t count = 1;
+        while (size_mb && (count * 2) * sizeof(entry) <= size_mb * 1024 * 1024)
+            count *= 2;
+        if (size_mb)
+            entries.resize(count);
+    }
+
+    bool enabled() const
+    {
+        return !entries.empty();
+    }
+
+    bool probe(const uint64_t key, const int depth, uint64_t& count) const
+    {
+        const entry& e = entries[key & (entries.size() - 1)];
+        if (e.key != key || e.depth != uint64_t(depth))
+            return false;
+        count = e.count;
+        return true;
+    }
+
+    void store(const uint64_t key, const int depth, const uint64_t count)
+    {
+        entries[key & (entries.size() - 1)] = {key, uint64_t(depth), count};
+    }
+
+  private:
+    struct entry
+    {
+        uint64_t key = 0;
+        uint64_t depth = 0;
+        uint64_t count = 0;
+    };
+    vector<entry> entries;
+};
+
+class Perft
+{
+  public:
+    Perft(const size_t table_mb, const bool check) : table(table_mb), check(check)
+    {
+    }
+
+    uint64_t run(Position& pos, const bool color, const int depth)
+    {
+        if (depth == 0)
+            return 1;
+        move_list turns;
+        Rules::find_turns(color, pos, turns);
+        // Листья не обходятся: их число — число ходов
+        if (depth == 1 && !check)
+            return turns.size();
+
+        const uint64_t key = color ? pos.hash ^ ZOBRIST_BLACK_TURN : pos.hash;
+        uint64_t count = 0;
+        if (table.enabled() && table.probe(key, depth, count))
+            return count;
+        for (const auto& turn : turns)
+        {
+            const Position before = pos;
+            const turn_undo undo = pos.make_turn(turn);
+            if (check && pos.hash != pos.calc_hash())
+                throw runtime_error("hash mismatch after " + turn.notation());
+            if (check && pos.counters != pos.calc_counters())
+                throw runtime_error("counters mismatch after " + turn.notation());
+            count += run(pos, !color, depth - 1);
+            pos.unmake_turn(turn, undo);
+            if (check && (pos != before || pos.hash != before.hash || pos.counters != before.counters))
+                throw runtime_error("unmake mismatch after " + turn.notation());
+        }
+        if (table.enabled())
+            table.store(key, depth, count);
+        return count;
+    }
+
+  private:
+    Perft_table table;
+    bool check;
+};
+
+// Позиции совпадают вместе с ключом и счётчиками оценки
+bool same(const Position& a, const Position& b)
+{
+    return a == b && a.hash == b.hash && a.counters == b.counters;
+}
+
+// Сколько раз позиция после n шагов встречалась раньше с той же очередью хода,
+// перебором по всем позициям партии после последнего взятия или превращения.
+// reversible[i] — шаг i (из позиции i в позицию i + 1) тихий и без превращения.
+int count_repetitions(const vector<Position>& positions, const vector<bool>& reversible, const size_t n)
+{
+    size_t first = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!reversible[i])
+            first = i + 1;
+    }
+    int res = 0;
+    for (size_t j = first; j < n; ++j)
+    {
+        if ((n - j) % 2 == 0 && same(positions[j], positions[n]))
+            ++res;
+    }
+    return res;
+}
+
+// Проверка истории партии State на случайных партиях. Ходы делаются по одному шагу, как их
+// показывает Board, а позиции после каждого шага отдельно запоминаются через make_turn.
+// С ними сравниваются текущая позиция и repetitions() после каждого шага, position_at всех шагов,
+// откат всей партии через rollback и её повтор через redo (маски, ключ и счётчики оценки).
+// Бросает runtime_error при расхождении, возвращает число найденных повторений.
+int check_history(const int games, const size_t max_steps)
+{
+    mt19937 rng(12345);
+    int repetitions = 0;
+    for (int game = 0; game < games; ++game)
+    {
+        State state;
+        vector<Position> positions = {state.position()};
+        vector<bool> reversible;
+        bool color = false;
+        // Последний ход каждой стороны: дамки часто ходят обратно, чтобы в партиях были повторения
+        full_turn last[2];
+        while (positions.size() <= max_steps)
+        {
+            move_list turns;
+            Rules::find_turns(color, state.position(), turns);
+            if (turns.empty())
+                break;
+            full_turn turn = turns[rng() % turns.size()];
+            for (const auto& back : turns)
+            {
+                if (last[color].count && !back.is_beat() && back.from == last[color].to() &&
+                    back.to() == last[color].from && rng() % 2)
+                    turn = back;
+            }
+            last[color] = turn;
+            int beat_series = 0;
+            for (int i = 0; i < turn.count; ++i)
+            {
+                Position next = positions.back();
+                const turn_undo undo = next.make_turn(turn.hop(i));
+                beat_series += turn.is_beat();
+                state.move_piece(turn.hop(i), beat_series);
+                positions.push_back(next);
+                reversible.push_back(!turn.is_beat() && !undo.promoted);
+                if (!same(state.position(), next))
+                    throw runtime_error("history: position mismatch after " + turn.notation());
+                const int expected = count_repetitions(positions, reversible, positions.size() - 1);
+                if (state.repetitions() != expected)
+                    throw runtime_error("history: repetitions mismatch after " + turn.notation());
+                repetitions += expected;
+            }
+            color = !color;
+        }
+
+        if (state.history_size() != positions.size())
+            throw runtime_error("history: wrong history size");
+        for (size_t ply = 0; ply < positions.size(); ++ply)
+        {
+            if (!same(state.position_at(ply), positions[ply]))
+                throw runtime_error("history: position_at mismatch at ply " + to_string(ply));
+        }
+        // Откат до начала партии и повтор до конца, по ходу (серии ударов целиком)
+        while (state.history_size() > 1)
+        {
+            state.rollback();
+            const size_t n = state.history_size() - 1;
+            if (!same(state.position(), positions[n]))
+                throw runtime_error("history: rollback mismatch at ply " + to_string(n));
+            if (state.repetitions() != count_repetitions(positions, reversible, n))
+                throw runtime_error("history: repetitions mismatch after rollback to ply " + to_string(n));
+        }
+        while (state.redo())
+        {
+            const size_t n = state.history_size() - 1;
+            if (!same(state.position(), positions[n]))
+                throw runtime_error("history: redo mismatch at ply " + to_string(n));
+        }
+        if (state.history_size() != positions.size())
+            throw runtime_error("history: redo did not restore the whole game");
+    }
+    return repetitions;
+}
+
+int main(int argc, char* argv[])
+{
+    const int max_depth = argc > 1 ? atoi(argv[1]) : 9;
+    const size_t table_mb = argc > 2 ? size_t(atoi(argv[2])) : 0;
+    const bool check = argc > 3 && atoi(argv[3]) != 0;
+
+    bool ok = true;
+    for (const auto& p : POSITIONS)
+    {
+        cout << p.name << " (" << (p.color ? "black" : "white") << " to move)\n";
+        Perft perft(table_mb, check);
+        Position pos = parse(p.board);
+        for (int depth = 1; depth <= max_depth; ++depth)
+        {
+            auto start = chrono::steady_clock::now();
+            const uint64_t count = perft.run(pos, p.color, depth);
+            auto end = chrono::steady_clock::now();
+            const double sec = chrono::duration<double>(end - start).count();
+            cout << "  depth " << depth << ": " << count << " nodes, " << int(sec * 1000) << " millisec, "
+                 << uint64_t(sec > 0 ? count / sec : 0) << " nodes/sec";
+            if (depth <= int(p.counts.size()))
+            {
+                const bool match = count == p.counts[depth - 1];
+                ok = ok && match;
+                cout << (match ? ", ok" : ", expected " + to_string(p.counts[depth - 1]));
+            }
+            cout << "\n";
+        }
+    }
+    if (check)
+    {
+        const int games = 200;
+        const int repetitions = check_history(games, 300);
+        cout << "History check: " << games << " games, " << repetitions << " repetitions, ok\n";
+    }
+    cout << (ok ? "All counts match\n" : "MISMATCH\n");
+    return ok ? 0 : 1;
+}
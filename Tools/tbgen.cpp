@@ -0,0 +1,298 @@
+// Построение таблиц эндшпиля ретроградным анализом, без окна и без SDL.
+// Использование: tbgen [число фигур] [каталог] [потоки]
+// По умолчанию строятся таблицы до 4 фигур в каталог Tablebases/ на всех ядрах.
+// Таблицы строятся слоями: слой — все наборы с одинаковым числом фигур и шашек.
+// Ход в пределах слоя не меняет набор (кроме обмена сторон), удар уводит в слой
+// с меньшим числом фигур, превращение — в слой с меньшим числом шашек, поэтому
+// к началу слоя все нужные младшие слои уже готовы.
+// Готовый слой сразу пишется на диск; при повторном запуске слои, файлы которых
+// уже есть, не пересчитываются, а читаются, так что прерванное построение продолжается.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Game/Rules.h"
+#include "../Game/Tablebase.h"
+
+using namespace std;
+
+// Таблица одного набора фигур в памяти. Значения атомарные: потоки пишут
+// разные позиции, но читают значения соседних, которые пишут другие потоки.
+struct tb_table
+{
+    int counts[4] = {};
+    size_t size = 0;
+    unique_ptr<atomic<uint8_t>[]> values;
+    uint8_t max_dist = 0;
+};
+
+class Generator
+{
+  public:
+    Generator(const string& dir, const int threads) : dir(dir), threads(threads), tables(Tablebase::SIGNATURES)
+    {
+    }
+
+    // Строит все слои до max_pieces фигур по возрастанию числа фигур и шашек
+    void run(const int max_pieces)
+    {
+        for (int n = 2; n <= max_pieces; ++n)
+        {
+            for (int men = 0; men <= n; ++men)
+                build_layer(n, men);
+        }
+    }
+
+  private:
+    // Слой: все наборы из n фигур, среди которых men шашек, у каждой стороны хотя бы одна фигура
+    void build_layer(const int n, const int men)
+    {
+        vector<int> codes;
+        for (int own_men = 0; own_men <= men; ++own_men)
+        {
+            for (int own_kings = 0; own_kings <= n - men; ++own_kings)
+            {
+                const int counts[4] = {own_men, own_kings, men - own_men, n - men - own_kings};
+                if (counts[0] + counts[1] == 0 || counts[2] + counts[3] == 0)
+                    continue;
+                if (*max_element(counts, counts + 4) > Tablebase::MAX_COUNT)
+                    continue;
+                codes.push_back(Tablebase::encode(counts));
+            }
+        }
+        if (codes.empty())
+            return;
+
+        bool on_disk = true;
+        for (const int code : codes)
+            on_disk = on_disk && read(code);
+        if (on_disk)
+        {
+            cout << "Layer " << n << " pieces, " << men << " men: loaded\n";
+            return;
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (const int code : codes)
+            allocate(code);
+
+        // Дистанции младших слоёв: пока итерации не дошли до них, пустая итерация не означает конец
+        int lower_dist = 0;
+        for (const auto& table : tables)
+        {
+            if (table && find(codes.begin(), codes.end(), Tablebase::encode(table->counts)) == codes.end())
+                lower_dist = max(lower_dist, int(table->max_dist));
+        }
+
+        // Итерация 0: невозможные позиции и позиции без ходов (проигрыш сразу)
+        for (const int code : codes)
+            parallel_for(*tables[code], [&](tb_table& table, const size_t index) { init(table, index); });
+
+        // Итерация k: при нечётном k — выигрыши за k полуходов (есть ход в проигрыш за k - 1),
+        // при чётном — проигрыши за k полуходов (все ходы ведут в выигрыш соперника не дальше k - 1).
+        // Новые значения итерации имеют дистанцию k, а читаются только дистанции до k - 1,
+        // поэтому потоки не зависят от порядка, в котором пишут соседи.
+        int empty_iterations = 0;
+        for (int k = 1; empty_iterations < 2 || k <= lower_dist + 1; ++k)
+        {
+            if (k > TB_MAX_DIST)
+                throw runtime_error("tablebase distance does not fit into one byte");
+            atomic<size_t> changed(0);
+            for (const int code : codes)
+            {
+                parallel_for(*tables[code], [&](tb_table& table, const size_t index) {
+                    if (step(table, index, k))
+                        ++changed;
+                });
+            }
+            empty_iterations = changed ? 0 : empty_iterations + 1;
+        }
+
+        auto end = chrono::steady_clock::now();
+        for (const int code : codes)
+            write(code);
+        cout << "Layer " << n << " pieces, " << men << " men: "
+             << int(chrono::duration<double>(end - start).count()) << " sec\n";
+    }
+
+    void allocate(const int code)
+    {
+        auto table = make_unique<tb_table>();
+        Tablebase::decode(code, table->counts);
+        table->size = Tablebase::size(table->counts);
+        table->values.reset(new atomic<uint8_t>[table->size]);
+        tables[code] = move(table);
+    }
+
+    void init(tb_table& table, const size_t index)
+    {
+        Position pos;
+        uint8_t value = TB_INVALID;
+        if (Tablebase::unrank(table.counts, index, pos))
+        {
+            move_list turns;
+            Rules::find_turns(0, pos, turns);
+            value = turns.empty() ? TB_LOSS : TB_DRAW;
+        }
+        table.values[index].store(value, memory_order_relaxed);
+    }
+
+    // Одна позиция на итерации k. Возвращает true, если значение найдено.
+    bool step(tb_table& table, const size_t index, const int k)
+    {
+        if (table.values[index].load(memory_order_relaxed) != TB_DRAW)
+            return false;
+        Position pos;
+        Tablebase::unrank(table.counts, index, pos);
+        move_list turns;
+        Rules::find_turns(0, pos, turns);
+        bool all_wins = true;
+        for (const auto& turn : turns)
+        {
+            Position child = pos;
+            child.make_turn(turn);
+            const uint8_t value = lookup(child);
+            if (k % 2 && value == TB_LOSS + k - 1)
+            {
+                table.values[index].store(uint8_t(k), memory_order_relaxed);
+                return true;
+            }
+            if (value == TB_DRAW || value >= TB_LOSS || value > k - 1)
+                all_wins = false;
+        }
+        if (k % 2 || !all_wins)
+            return false;
+        table.values[index].store(uint8_t(TB_LOSS + k), memory_order_relaxed);
+        return true;
+    }
+
+    // Значение позиции после хода белых: ходят чёрные
+    uint8_t lookup(const Position& child) const
+    {
+        int counts[4];
+        size_t index = 0;
+        if (!Tablebase::locate(child, 1, counts, index))
+            throw runtime_error("position after a move is out of the tablebase encoding");
+        if (counts[0] + counts[1] == 0)
+            return TB_LOSS;
+        const tb_table* table = tables[Tablebase::encode(counts)].get();
+        if (!table)
+            throw runtime_error("table " + Tablebase::file_name(counts) + " is not built before its use");
+        return table->values[index].load(memory_order_relaxed);
+    }
+
+    template <class F> void parallel_for(tb_table& table, F f)
+    {
+        const size_t chunk = 1 << 14;
+        atomic<size_t> next(0);
+        auto worker = [&]() {
+            while (true)
+            {
+                const size_t begin = next.fetch_add(chunk);
+                if (begin >= table.size)
+                    break;
+                const size_t end = min(table.size, begin + chunk);
+                for (size_t index = begin; index < end; ++index)
+                    f(table, index);
+            }
+        };
+        vector<thread> pool;
+        for (int i = 1; i < threads; ++i)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& th : pool)
+            th.join();
+    }
+
+    // Читает готовую таблицу с диска, false — файла нет или он повреждён
+    bool read(const int code)
+    {
+        int counts[4];
+        Tablebase::decode(code, counts);
+        ifstream fin(dir + Tablebase::file_name(counts), ios::binary);
+        tb_header header;
+        if (!fin.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+        if (memcmp(header.magic, tb_header().magic, 4) != 0 || header.version != tb_header().version)
+            return false;
+        allocate(code);
+        tb_table& table = *tables[code];
+        vector<uint8_t> buf(table.size);
+        if (!fin.read(reinterpret_cast<char*>(buf.data()), buf.size()) || fin.peek() != EOF)
+        {
+            tables[code].reset();
+            return false;
+        }
+        for (size_t i = 0; i < table.size; ++i)
+            table.values[i].store(buf[i], memory_order_relaxed);
+        table.max_dist = header.max_dist;
+        return true;
+    }
+
+    // Пишет таблицу во временный файл и переименовывает его, чтобы прерванная запись
+    // не оставила файл, похожий на готовый
+    void write(const int code)
+    {
+        tb_table& table = *tables[code];
+        tb_header header;
+        size_t wins = 0, losses = 0, draws = 0;
+        vector<uint8_t> buf(table.size);
+        for (size_t i = 0; i < table.size; ++i)
+        {
+            buf[i] = table.values[i].load(memory_order_relaxed);
+            if (buf[i] == TB_INVALID)
+                continue;
+            if (buf[i] == TB_DRAW)
+                ++draws;
+            else if (buf[i] < TB_LOSS)
+                ++wins;
+            else
+                ++losses;
+            if (buf[i] != TB_DRAW)
+                header.max_dist = max(header.max_dist, uint8_t(buf[i] < TB_LOSS ? buf[i] : buf[i] - TB_LOSS));
+        }
+        table.max_dist = header.max_dist;
+        for (int i = 0; i < 4; ++i)
+            header.counts[i] = uint8_t(table.counts[i]);
+
+        const string path = dir + Tablebase::file_name(table.counts);
+        {
+            ofstream fout(path + ".tmp", ios::binary | ios::trunc);
+            fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            fout.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+            if (!fout)
+                throw runtime_error("can't write " + path + ".tmp");
+        }
+        if (rename((path + ".tmp").c_str(), path.c_str()) != 0)
+            throw runtime_error("can't rename " + path + ".tmp");
+        cout << "  " << Tablebase::file_name(table.counts) << ": " << wins << " wins, " << draws << " draws, "
+             << losses << " losses, max distance " << int(header.max_dist) << "\n";
+    }
+
+    string dir;
+    int threads;
+    vector<unique_ptr<tb_table>> tables;
+};
+
+int main(int argc, char* argv[])
+{
+    const int pieces = argc > 1 ? atoi(argv[1]) : 4;
+    string dir = argc > 2 ? argv[2] : "Tablebases/";
+    if (!dir.empty() && dir.back() != '/' && dir.back() != '\\')
+        dir += '/';
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+    if (threads <= 0)
+        threads = max(1, int(thread::hardware_concurrency()));
+
+    Generator generator(dir, threads);
+    generator.run(pieces);
+    return 0;
+}
@@ -1,9 +1,23 @@
+#include <iostream>
+#include <stdexcept>
+
 #include "Game/Game.h"
 
 int main(int argc, char* argv[])
 {
-    Game g;
-    g.play();
+    // Неверные настройки и файлы данных сообщаются при запуске, до начала партии
+    try
+    {
+        Game g;
+        g.play();
+    }
+    catch (const runtime_error& e)
+    {
+        ofstream fout(project_path + "log.txt", ios_base::app);
+        fout << "Error: " << e.what() << endl;
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
 
     return 0;
 }